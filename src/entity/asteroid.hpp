@@ -2,9 +2,10 @@
 #define ASTEROID_HPP_
 
 #include <cmath>
+#include <type_traits>
 
-#include "util.hpp"
 #include "typedef.hpp"
+#include "rng.hpp"
 #include "entity.hpp"
 #include "ltmath.hpp"
 
@@ -19,22 +20,35 @@ using namespace LookupTableMath;
  * @note Check MAX_VERTEXES for the maximum amount, and the vtx_count field to check how many are actually used in there.
  */
 struct AsteroidShape : public EntityShape {
+    static constexpr f32 MIN_SCALE = 5.0f;
+    static constexpr f32 MAX_SCALE = 55.0f;
+
     f32 scale;
 
-    void init_shape() {
+    /**
+     * @brief Get the largest distance a vertex can have from the center, for a given scale.
+     * @param scale The scale of the asteroid.
+     * @return The maximum radius of the shape.
+     */
+    static constexpr f32 max_radius(f32 scale) { return (scale + 20.0f) + (scale * scale) / 16.0f; }
+
+    void init_shape(Rng& rng) {
         usize vtx_count = data().vtx_count;
         f32_2* vertexes = data().vertexes;
 
         for (usize i = 0; i < vtx_count; i++) {
             f32 angle = i * (2.0f * M_PI / static_cast<f32>(vtx_count));
-            f32 modulo = util::randf() * (scale + 20.0f) + (scale * scale) / 16.0f;
+            f32 modulo = rng.next_f32() * (scale + 20.0f) + (scale * scale) / 16.0f;
+            f32 sin_angle, cos_angle;
 
-            vertexes[i] = { modulo * ltcosf(angle), modulo * ltsinf(angle) };
+            ltsincosf_q(angle, sin_angle, cos_angle);
+            vertexes[i] = { modulo * cos_angle, modulo * sin_angle };
         }
     }
 
-    AsteroidShape(usize vtx_count, f32 scale) : EntityShape(vtx_count), scale(scale) {
-        init_shape();
+    AsteroidShape(usize vtx_count, f32 scale, Rng& rng) : EntityShape(vtx_count), scale(scale) {
+        init_shape(rng);
+        update_metadata();
     }
 };
 
@@ -42,16 +56,17 @@ struct AsteroidShape : public EntityShape {
  * @brief An asteroid entity.
  *
  * The asteroid is a simple entity that has a shape and a position.
- * While the shape data is stored by the AsteroidShape struct, these values aren't used directly.
- * Instead, the Entity this class inherits from uses the shape data to calculate the final relative position of the vertexes.
+ * A random asteroid picks one of the shared asteroid variants of the ShapeLibrary (the default one takes the first
+ * variant). Any other shape has to be added to the library once by the caller, then passed by id.
+ * The Entity this class inherits from uses the shape data to calculate the final relative position of the vertexes.
  */
 class Asteroid : public Entity {
-private:
-    AsteroidShape shape;
-    
 public:
-    Asteroid() : Entity(&shape), shape(util::randi(6, AsteroidShape::MAX_VERTEXES), util::randf() * 50.0f + 5.0f) {}
-    Asteroid(usize vtx_count, f32 scale) : Entity(&shape), shape(vtx_count, scale) {}
+    Asteroid() : Entity(ShapeLibrary::shared().get_asteroid(0)) {}
+    explicit Asteroid(Rng& rng) : Entity(ShapeLibrary::shared().get_random_asteroid(rng)) {}
+    explicit Asteroid(ShapeId shape_id) : Entity(shape_id) {}
 };
 
+static_assert(std::is_trivially_copyable<Asteroid>::value, "Asteroid must stay trivially copyable, shapes belong to the ShapeLibrary.");
+
 #endif
\ No newline at end of file
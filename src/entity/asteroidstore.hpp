@@ -0,0 +1,490 @@
+#ifndef ASTEROIDSTORE_HPP_
+#define ASTEROIDSTORE_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "typedef.hpp"
+#include "util.hpp"
+#include "rng.hpp"
+#include "entity.hpp"
+#include "asteroid.hpp"
+#include "ltmath.hpp"
+#include "vtxkernel.hpp"
+#include "shapelibrary.hpp"
+#include "narrowphase.hpp"
+
+using namespace LookupTableMath;
+
+/**
+ * @brief Structure of arrays storage for all the asteroids of the world.
+ *
+ * Instead of one Asteroid object per slot, every field lives in its own contiguous array, so that integrating
+ * positions and angles only touches the kinematics, and the vertex data is only touched when the outlines are
+ * rebuilt. Shapes are referenced by id into the shared ShapeLibrary, and the world space outlines are packed one
+ * after the other in a single pool, with room in every slot for the largest shape plus one vertex to close the drawn
+ * shape, so that set_shape() can give an asteroid any other shape in place.
+ *
+ * The asteroids behave like Asteroid entities: stepping only integrates the kinematics and bounds each asteroid with
+ * its shape radius, while the outline is rebuilt lazily, the first time a collision test or the renderer asks for it
+ * after a change. Unlike entities, each asteroid also keeps its orientation as a unit complex number, which stepping
+ * turns without any trigonometry, so that rebuilding the outline doesn't need any either.
+ *
+ * Asteroids are simulated at one of three levels of detail, decided by update_tiers() from where they are: NEAR ones
+ * get the full physics, MID ones are only integrated, with no collision tests, and FAR ones are frozen in place.
+ * A frozen asteroid remembers the store time it was frozen at, and when it comes back into a closer tier, or is
+ * changed through a Ref, it is moved by its velocities over the whole elapsed time at once. Nothing acts on a far
+ * asteroid, so this lands it where integrating every step would have, without touching it in between.
+ *
+ * The store is sized to the capacity of the world, which keeps its live asteroids in the first indexes through an
+ * EntityPool, and compacts the storage with swap() when one is released.
+ *
+ * @note Use get(index) to access a single asteroid through a Ref, which has the same getters and setters as an
+ * Entity.
+ */
+class AsteroidStore {
+public:
+    enum Tier : u8 {
+        NEAR,
+        MID,
+        FAR
+    };
+
+private:
+    static constexpr u8 RESYNC_TICKS = 64;
+    static constexpr usize SLOT_VERTEXES = EntityShape::MAX_VERTEXES + 1;
+
+    std::vector<f32_2> positions;
+    std::vector<f32_2> velocities;
+    std::vector<f32> angles;
+    std::vector<f32> angular_velocities;
+    std::vector<f32_2> bounding_boxes; // Minimum and maximum corner of each asteroid, one after the other.
+    std::vector<u8> out_of_view; // Any tier but NEAR, which keeps the asteroid out of collisions and drawing.
+    std::vector<u8> tiers;
+    std::vector<f64> frozen_times; // Store time when a FAR asteroid was last brought up to date.
+    std::vector<f32_2> previous_positions;
+    std::vector<f32> previous_angles;
+    std::vector<f32_2> orientations; // Cosine and sine of each angle, as a unit complex number.
+    std::vector<f32_2> spin_steps; // Rotation of the orientation in a step of dt_scale 1.
+    std::vector<u8> spin_ticks;
+
+    std::vector<ShapeId> shape_ids;
+    std::vector<f32> radii;
+    std::vector<u32> vtx_counts;
+    std::vector<f32_2> rel_vertexes;
+    std::vector<f32_2> outline_bounding_boxes;
+    std::vector<f32> outline_sin_angles;
+    std::vector<f32> outline_cos_angles;
+    std::vector<u8> outline_dirty;
+
+    f64 time = 0.0; // Sum of the dt_scale of every step.
+
+    f32_2* rel_vertexes_of(usize index) { return &rel_vertexes[index * SLOT_VERTEXES]; }
+    const f32_2* rel_vertexes_of(usize index) const { return &rel_vertexes[index * SLOT_VERTEXES]; }
+
+    void update_orientation(usize index) {
+        ltsincosf(angles[index], orientations[index].y, orientations[index].x);
+        outline_dirty[index] = 1;
+    }
+
+    /**
+     * @brief Rebuild the spin step, with the exact sine and cosine, as its error adds up at every step.
+     */
+    void update_spin_step(usize index) {
+        spin_steps[index] = { std::cos(angular_velocities[index]), std::sin(angular_velocities[index]) };
+    }
+
+    void update_bounding_box(usize index) {
+        const f32_2 pos = positions[index];
+        const f32 radius = radii[index];
+
+        bounding_boxes[2 * index] = { pos.x - radius, pos.y - radius };
+        bounding_boxes[2 * index + 1] = { pos.x + radius, pos.y + radius };
+        outline_dirty[index] = 1;
+    }
+
+    /**
+     * @brief Move a FAR asteroid by its velocities over the time elapsed since it was frozen.
+     */
+    void thaw(usize index) {
+        if (tiers[index] != FAR)
+            return;
+
+        const f32 elapsed = static_cast<f32>(time - frozen_times[index]);
+        frozen_times[index] = time;
+        if (elapsed == 0.0f)
+            return;
+
+        positions[index].x += velocities[index].x * elapsed;
+        positions[index].y += velocities[index].y * elapsed;
+        angles[index] += angular_velocities[index] * elapsed;
+        previous_positions[index] = positions[index];
+        previous_angles[index] = angles[index];
+        update_orientation(index);
+        update_bounding_box(index);
+    }
+
+    Narrowphase::Body body_of(usize index) const {
+        return { shape_ids[index], rel_vertexes_of(index), positions[index], outline_sin_angles[index], outline_cos_angles[index] };
+    }
+
+public:
+    /**
+     * @brief Rebuild the world space outline of an asteroid and its tight bounding box, if outdated.
+     * @note Only touches the data of that asteroid, so different asteroids can be updated concurrently.
+     */
+    void update_outline(usize index) {
+        if (!outline_dirty[index])
+            return;
+
+        outline_sin_angles[index] = orientations[index].y;
+        outline_cos_angles[index] = orientations[index].x;
+
+        const VertexKernel::Job job = {
+            ShapeLibrary::shared().load_vertexes(shape_ids[index], rel_vertexes_of(index)), vtx_counts[index], positions[index],
+            outline_sin_angles[index], outline_cos_angles[index], rel_vertexes_of(index), &outline_bounding_boxes[2 * index]
+        };
+
+        VertexKernel::transform(&job, 1);
+        outline_dirty[index] = 0;
+    }
+
+    /**
+     * @brief Handle to a single asteroid, with the same accessors as an Entity.
+     */
+    class Ref {
+    private:
+        AsteroidStore* store;
+        usize index;
+
+    public:
+        Ref(AsteroidStore* store, usize index) : store(store), index(index) {}
+
+        /* A FAR asteroid reports where it would be by now, and is brought up to date before any change. */
+
+        const f32_2 get_position() const {
+            const f32_2 position = store->positions[index];
+            if (store->tiers[index] != FAR)
+                return position;
+
+            const f32 elapsed = static_cast<f32>(store->time - store->frozen_times[index]);
+            return { position.x + store->velocities[index].x * elapsed, position.y + store->velocities[index].y * elapsed };
+        }
+
+        const f32_2 get_velocity() const { return store->velocities[index]; }
+
+        f32 get_angle() const {
+            if (store->tiers[index] != FAR)
+                return store->angles[index];
+
+            return store->angles[index] + store->angular_velocities[index] * static_cast<f32>(store->time - store->frozen_times[index]);
+        }
+
+        f32 get_angular_velocity() const { return store->angular_velocities[index]; }
+        const f32_2* get_bounding_box() const { return &store->bounding_boxes[2 * index]; }
+        Tier get_tier() const { return static_cast<Tier>(store->tiers[index]); }
+        ShapeId get_shape_id() const { return store->shape_ids[index]; }
+
+        void set_position(f32_2 position) { store->thaw(index); store->positions[index] = store->previous_positions[index] = position; store->update_bounding_box(index); }
+        void set_velocity(f32_2 velocity) { store->thaw(index); store->velocities[index] = velocity; }
+        void set_angle(f32 angle) { store->thaw(index); store->angles[index] = store->previous_angles[index] = angle; store->update_orientation(index); }
+        void set_angular_velocity(f32 angular_velocity) { store->thaw(index); store->angular_velocities[index] = angular_velocity; store->update_spin_step(index); }
+
+        void add_position(f32_2 position) { store->thaw(index); store->positions[index].x += position.x; store->positions[index].y += position.y; store->update_bounding_box(index); }
+        void add_velocity(f32_2 velocity) { store->thaw(index); store->velocities[index].x += velocity.x; store->velocities[index].y += velocity.y; }
+        void add_angle(f32 angle) { store->thaw(index); store->angles[index] += angle; store->update_orientation(index); }
+        void add_angular_velocity(f32 angular_velocity) { store->thaw(index); store->angular_velocities[index] += angular_velocity; store->update_spin_step(index); }
+
+        usize get_entity_vtx_count() const { return store->vtx_counts[index] + 1; }
+
+        /**
+         * @brief Get the world space outline, rebuilding it first if outdated.
+         */
+        const f32_2* get_entity_vtx_array() const {
+            store->update_outline(index);
+            return store->rel_vertexes_of(index);
+        }
+
+        /**
+         * @brief Build the world space outline at a pose between the previous state and the current one, like
+         * Entity::get_interpolated_vtx_array.
+         */
+        const f32_2* get_interpolated_vtx_array(f32 alpha, f32_2* out) const {
+            const f32_2 previous_position = store->previous_positions[index];
+            const f32_2 position = store->positions[index];
+            const f32 previous_angle = store->previous_angles[index];
+            const f32 lerp_angle = previous_angle + (store->angles[index] - previous_angle) * alpha;
+            f32 sin_angle, cos_angle;
+            f32_2 bbox[2];
+
+            ltsincosf(lerp_angle, sin_angle, cos_angle);
+
+            const VertexKernel::Job job = {
+                ShapeLibrary::shared().load_vertexes(store->shape_ids[index], out), store->vtx_counts[index],
+                { previous_position.x + (position.x - previous_position.x) * alpha, previous_position.y + (position.y - previous_position.y) * alpha },
+                sin_angle, cos_angle, out, bbox
+            };
+
+            VertexKernel::transform(&job, 1);
+            return out;
+        }
+    };
+
+    Ref get(usize index) { return Ref(this, index); }
+    usize size() const { return positions.size(); }
+
+    /**
+     * @brief Resize the storage, picking a random shape variant for every added asteroid.
+     * @param count The new amount of asteroids.
+     * @param rng The generator picking the shape variants.
+     */
+    void resize(usize count, Rng& rng) {
+        const usize old_count = size();
+
+        positions.resize(count, VECTOR2ZERO);
+        velocities.resize(count, VECTOR2ZERO);
+        angles.resize(count, 0.0f);
+        angular_velocities.resize(count, 0.0f);
+        bounding_boxes.resize(2 * count, VECTOR2ZERO);
+        out_of_view.resize(count, 0);
+        tiers.resize(count, NEAR);
+        frozen_times.resize(count, time);
+        previous_positions.resize(count, VECTOR2ZERO);
+        previous_angles.resize(count, 0.0f);
+        orientations.resize(count, { 1.0f, 0.0f });
+        spin_steps.resize(count, { 1.0f, 0.0f });
+        spin_ticks.resize(count, 0);
+        shape_ids.resize(count);
+        radii.resize(count);
+        vtx_counts.resize(count);
+        outline_bounding_boxes.resize(2 * count, VECTOR2ZERO);
+        outline_sin_angles.resize(count, 0.0f);
+        outline_cos_angles.resize(count, 1.0f);
+        outline_dirty.resize(count, 1);
+        rel_vertexes.resize(count * SLOT_VERTEXES, VECTOR2ZERO);
+
+        const ShapeLibrary& library = ShapeLibrary::shared();
+
+        for (usize i = old_count; i < count; ++i) {
+            shape_ids[i] = library.get_random_asteroid(rng);
+            radii[i] = library.get_radius(shape_ids[i]);
+            vtx_counts[i] = library.get_vtx_count(shape_ids[i]);
+            spin_ticks[i] = i % RESYNC_TICKS;
+            update_bounding_box(i);
+        }
+    }
+
+    /**
+     * @brief Give an asteroid another shape of the library, keeping its pose.
+     */
+    void set_shape(usize index, ShapeId id) {
+        const ShapeLibrary& library = ShapeLibrary::shared();
+
+        shape_ids[index] = id;
+        radii[index] = library.get_radius(id);
+        vtx_counts[index] = library.get_vtx_count(id);
+        update_bounding_box(index);
+    }
+
+    /**
+     * @brief Exchange two asteroids, shapes and outlines included, to keep the live asteroids packed.
+     */
+    void swap(usize index, usize other) {
+        std::swap(positions[index], positions[other]);
+        std::swap(velocities[index], velocities[other]);
+        std::swap(angles[index], angles[other]);
+        std::swap(angular_velocities[index], angular_velocities[other]);
+        std::swap(bounding_boxes[2 * index], bounding_boxes[2 * other]);
+        std::swap(bounding_boxes[2 * index + 1], bounding_boxes[2 * other + 1]);
+        std::swap(out_of_view[index], out_of_view[other]);
+        std::swap(tiers[index], tiers[other]);
+        std::swap(frozen_times[index], frozen_times[other]);
+        std::swap(previous_positions[index], previous_positions[other]);
+        std::swap(previous_angles[index], previous_angles[other]);
+        std::swap(orientations[index], orientations[other]);
+        std::swap(spin_steps[index], spin_steps[other]);
+        std::swap(spin_ticks[index], spin_ticks[other]);
+
+        // The outlines stay in their slots, so both are rebuilt when next needed.
+        std::swap(shape_ids[index], shape_ids[other]);
+        std::swap(radii[index], radii[other]);
+        std::swap(vtx_counts[index], vtx_counts[other]);
+        outline_dirty[index] = outline_dirty[other] = 1;
+    }
+
+    const f32_2* get_bounding_box(usize index) const { return &bounding_boxes[2 * index]; }
+    const f32_2* get_bounding_boxes() const { return bounding_boxes.data(); }
+
+    bool is_out_of_view(usize index) const { return out_of_view[index]; }
+    const u8* get_out_of_view_flags() const { return out_of_view.data(); }
+
+    /**
+     * @brief Keep the current positions and angles of the asteroids in [begin, end) as their previous state, like
+     * Entity::store_previous_pose.
+     */
+    void store_previous_poses(usize begin, usize end) {
+        for (usize i = begin; i < end; ++i) {
+            previous_positions[i] = positions[i];
+            previous_angles[i] = angles[i];
+        }
+    }
+
+    f64 get_time() const { return time; }
+
+    /**
+     * @brief Advance the store time, once per step of the whole store, after stepping every range.
+     */
+    void advance_time(f32 dt_scale) { time += dt_scale; }
+
+    /**
+     * @brief Sort every asteroid into its tier, NEAR inside the near area, MID inside the mid area and FAR elsewhere.
+     *
+     * A FAR asteroid is placed by where it would be by now, and only brought up to date once it leaves the FAR tier.
+     * Every tier but NEAR is flagged as out of view.
+     *
+     * @param near_min The minimum corner of the near area.
+     * @param near_max The maximum corner of the near area.
+     * @param mid_min The minimum corner of the mid area, which contains the near one.
+     * @param mid_max The maximum corner of the mid area.
+     */
+    void update_tiers(f32_2 near_min, f32_2 near_max, f32_2 mid_min, f32_2 mid_max) { update_tiers(near_min, near_max, mid_min, mid_max, 0, size()); }
+
+    /**
+     * @brief Sort only the asteroids in [begin, end), so that ranges can be sorted concurrently.
+     */
+    void update_tiers(f32_2 near_min, f32_2 near_max, f32_2 mid_min, f32_2 mid_max, usize begin, usize end) {
+        for (usize i = begin; i < end; ++i) {
+            const f32_2 pos = get(i).get_position();
+            const bool in_near = pos.x >= near_min.x and pos.x <= near_max.x and pos.y >= near_min.y and pos.y <= near_max.y;
+            const bool in_mid = pos.x >= mid_min.x and pos.x <= mid_max.x and pos.y >= mid_min.y and pos.y <= mid_max.y;
+            const u8 tier = in_near ? NEAR : in_mid ? MID : FAR;
+
+            if (tier != FAR)
+                thaw(i);
+            else if (tiers[i] != FAR)
+                frozen_times[i] = time;
+
+            tiers[i] = tier;
+            out_of_view[i] = tier != NEAR;
+        }
+    }
+
+    /**
+     * @brief Integrate position and angle of all the asteroids but the FAR ones, and update their bounding boxes.
+     *
+     * The orientation is turned by the spin step of the asteroid, a complex multiplication, so that a step of
+     * dt_scale 1 needs no trigonometry. Every RESYNC_TICKS steps the orientation is instead rebuilt from the angle,
+     * which brings it back to unit length and drops the rounding drift, staggered so that only a few asteroids do it
+     * in any given step.
+     *
+     * @param dt_scale The delta time scaling for this step.
+     */
+    void step(f32 dt_scale) { step(dt_scale, 0, size()); }
+
+    /**
+     * @brief Step only the asteroids in [begin, end), so that ranges can be stepped concurrently.
+     */
+    void step(f32 dt_scale, usize begin, usize end) {
+        for (usize i = begin; i < end; ++i) {
+            if (tiers[i] == FAR)
+                continue;
+
+            positions[i].x += velocities[i].x * dt_scale;
+            positions[i].y += velocities[i].y * dt_scale;
+            angles[i] += angular_velocities[i] * dt_scale;
+
+            if (++spin_ticks[i] == RESYNC_TICKS) {
+                spin_ticks[i] = 0;
+                update_orientation(i);
+            } else {
+                f32_2 spin = spin_steps[i];
+                if (dt_scale != 1.0f)
+                    ltsincosf(angular_velocities[i] * dt_scale, spin.y, spin.x);
+
+                const f32_2 o = orientations[i];
+                orientations[i] = { o.x * spin.x - o.y * spin.y, o.x * spin.y + o.y * spin.x };
+            }
+
+            update_bounding_box(i);
+        }
+    }
+
+    /**
+     * @brief Get an asteroid as seen by the Narrowphase, rebuilding its outline first if outdated.
+     */
+    Narrowphase::Body get_body(usize index) {
+        update_outline(index);
+        return body_of(index);
+    }
+
+    /**
+     * @brief Check if the bounding circles and boxes of two asteroids overlap.
+     */
+    bool is_broad_overlap(usize index, usize other) const {
+        return (
+            index != other and
+            Entity::is_circle_overlap(positions[index], radii[index], positions[other], radii[other]) and
+            Entity::is_overlap(get_bounding_box(index), get_bounding_box(other))
+        );
+    }
+
+    /**
+     * @brief Check if the bounding circles and boxes of an asteroid and an entity overlap.
+     */
+    bool is_broad_overlap(usize index, const Entity& other) const {
+        return (
+            Entity::is_circle_overlap(positions[index], radii[index], other.get_position(), ShapeLibrary::shared().get_radius(other.get_shape_id())) and
+            Entity::is_overlap(get_bounding_box(index), other.get_bounding_box())
+        );
+    }
+
+    /**
+     * @brief Run the Narrowphase between two asteroids whose outlines are already built.
+     * @note Doesn't modify the store, so it can run concurrently with other tests.
+     */
+    bool is_narrow_collision(usize index, usize other, Narrowphase::Contact* contact = nullptr) const {
+        if (!Entity::is_overlap(&outline_bounding_boxes[2 * index], &outline_bounding_boxes[2 * other]))
+            return false;
+
+        return Narrowphase::collide(body_of(index), body_of(other), contact);
+    }
+
+    /**
+     * @brief Run the Narrowphase between an asteroid and an entity, both with their outlines already built.
+     * @note Doesn't modify the store or the entity, so it can run concurrently with other tests.
+     */
+    bool is_narrow_collision(usize index, const Entity& other, Narrowphase::Contact* contact = nullptr) const {
+        if (!Entity::is_overlap(&outline_bounding_boxes[2 * index], other.get_outline_bounding_box()))
+            return false;
+
+        return Narrowphase::collide(body_of(index), other.get_body(), contact);
+    }
+
+    /**
+     * @brief Check if two asteroids collide, like Entity::is_collision.
+     */
+    bool is_collision(usize index, usize other, Narrowphase::Contact* contact = nullptr) {
+        if (!is_broad_overlap(index, other))
+            return false;
+
+        update_outline(index);
+        update_outline(other);
+
+        return is_narrow_collision(index, other, contact);
+    }
+
+    /**
+     * @brief Check if an asteroid collides with an entity, like Entity::is_collision.
+     */
+    bool is_collision(usize index, const Entity& other, Narrowphase::Contact* contact = nullptr) {
+        if (!is_broad_overlap(index, other))
+            return false;
+
+        update_outline(index);
+
+        return is_narrow_collision(index, other, contact);
+    }
+};
+
+#endif
\ No newline at end of file
@@ -2,112 +2,160 @@
 #define ENTITY_HPP_
 
 #include "typedef.hpp"
+#include "entityshape.hpp"
 #include "ltmath.hpp"
+#include "vtxkernel.hpp"
+#include "shapelibrary.hpp"
+#include "narrowphase.hpp"
 
 using namespace LookupTableMath;
 
-/**
- * @brief Base class for all entity vector shapes.
- *
- * The EntityShape struct provides a base for all entities that have a shape made up of vertexes.
- * It has a maximum amount of vertexes and a count of how many are actually used.
- *
- * This struct owns the vertexes array, which can then be passed by the EntityShapeData struct to the Entity.
- *
- * @note To change the point coordinates (like for relative position or rotation), use the Entity's rel_vertexes array.
- */
-class EntityShape {
-public:
-    static constexpr usize MAX_VERTEXES = 31;
-
-private:
-    struct EntityShapeData {
-        usize vtx_count;
-        f32_2* vertexes;
-    };
-
-    struct EntityShapeDataConst {
-        const usize vtx_count;
-        const f32_2* vertexes;
-    };
-
-    usize vtx_count;
-    f32_2 vertexes[MAX_VERTEXES];
-
-public:
-    EntityShapeData data() { return { vtx_count, vertexes }; }
-    EntityShapeDataConst data() const { return { vtx_count, vertexes }; }
-
-    EntityShape(usize vtx_count = 0) { this->vtx_count = vtx_count; }
-    EntityShape(usize vtx_count, const f32_2* vertexes) : vtx_count(vtx_count) {
-        for (usize i = 0; i < vtx_count; ++i)
-            this->vertexes[i] = vertexes[i];
-    }
-    EntityShape(const EntityShapeData& data) : vtx_count(data.vtx_count) {
-        for (usize i = 0; i < vtx_count; ++i)
-            vertexes[i] = data.vertexes[i];
-    }
-};
-
 /**
  * @brief Base class for all entities.
  *
  * The Entity class provides all protected members and get/setters for adding position and movement to every entity.
- * It also ties each entity to its shape base class, which provides information on the base vertexes that make it up.
+ * It also ties each entity to its shape in the ShapeLibrary, which provides information on the base vertexes that
+ * make it up. As the shape is only referenced by id, entities are trivially copyable.
  */
 class Entity {
 protected:
-    EntityShape* shape;
-    f32_2 rel_vertexes[EntityShape::MAX_VERTEXES + 1]; // Add one vertex to close the drawn shape.
+    ShapeId shape_id;
+    mutable f32_2 rel_vertexes[EntityShape::MAX_VERTEXES + 1]; // Add one vertex to close the drawn shape.
+    mutable f32_2 outline_bounding_box[2];
+    mutable f32 outline_sin_angle;
+    mutable f32 outline_cos_angle;
+    mutable bool outline_dirty;
     f32_2 bounding_box[2];
     f32_2 position;
     f32_2 velocity;
     f32 angle;
     f32 angular_velocity;
+    f32_2 previous_position;
+    f32 previous_angle;
 
-    bool ccw(const f32_2& a, const f32_2& b, const f32_2& c) const {
+    static bool ccw(const f32_2& a, const f32_2& b, const f32_2& c) {
         return (c.y - a.y) * (b.x - a.x) > (b.y - a.y) * (c.x - a.x);
     }
 
+    /**
+     * @brief Bound the shape at any angle with its radius, and mark the outline as outdated.
+     */
     void update_bounding_box() {
-        const usize vtx_count = shape->data().vtx_count;
+        const f32 radius = ShapeLibrary::shared().get_radius(shape_id);
 
-        bounding_box[0] = rel_vertexes[0];
-        bounding_box[1] = rel_vertexes[0];
+        bounding_box[0] = { position.x - radius, position.y - radius };
+        bounding_box[1] = { position.x + radius, position.y + radius };
+        outline_dirty = true;
+    }
 
-        for (usize i = 1; i < vtx_count; ++i) {
-            bounding_box[0].x = rel_vertexes[i].x < bounding_box[0].x ? rel_vertexes[i].x : bounding_box[0].x;
-            bounding_box[0].y = rel_vertexes[i].y < bounding_box[0].y ? rel_vertexes[i].y : bounding_box[0].y;
-            bounding_box[1].x = rel_vertexes[i].x > bounding_box[1].x ? rel_vertexes[i].x : bounding_box[1].x;
-            bounding_box[1].y = rel_vertexes[i].y > bounding_box[1].y ? rel_vertexes[i].y : bounding_box[1].y;
-        }
+    /**
+     * @brief Rebuild the world space outline and its tight bounding box, if outdated.
+     */
+    void update_outline() const {
+        if (!outline_dirty)
+            return;
+
+        const ShapeLibrary& library = ShapeLibrary::shared();
+        ltsincosf(angle, outline_sin_angle, outline_cos_angle);
+
+        const VertexKernel::Job job = {
+            library.load_vertexes(shape_id, rel_vertexes), library.get_vtx_count(shape_id), position, outline_sin_angle, outline_cos_angle, rel_vertexes, outline_bounding_box
+        };
+
+        VertexKernel::transform(&job, 1);
+        outline_dirty = false;
     }
 
 public:
-    Entity(EntityShape* shape, f32_2 position = { 0.0f, 0.0f }, f32_2 velocity = { 0.0f, 0.0f }, f32 angle = 0.0f, f32 angular_velocity = 0.0f)
-      : shape(shape), position(position), velocity(velocity), angle(angle), angular_velocity(angular_velocity) {}
+    Entity(ShapeId shape_id, f32_2 position = { 0.0f, 0.0f }, f32_2 velocity = { 0.0f, 0.0f }, f32 angle = 0.0f, f32 angular_velocity = 0.0f)
+      : shape_id(shape_id), position(position), velocity(velocity), angle(angle), angular_velocity(angular_velocity), previous_position(position), previous_angle(angle) {
+        update_bounding_box();
+    }
 
     const f32_2 get_position() const { return position; }
     const f32_2 get_velocity() const { return velocity; }
     const f32 get_angle() const { return angle; }
     const f32 get_angular_velocity() const { return angular_velocity; }
+    const f32_2* get_bounding_box() const { return bounding_box; }
 
-    void set_position(f32_2 position) { this->position = position; }
+    void set_position(f32_2 position) { this->position = previous_position = position; update_bounding_box(); }
     void set_velocity(f32_2 velocity) { this->velocity = velocity; }
-    void set_angle(f32 angle) { this->angle = angle; }
+    void set_angle(f32 angle) { this->angle = previous_angle = angle; outline_dirty = true; }
     void set_angular_velocity(f32 angular_velocity) { this->angular_velocity = angular_velocity; }
 
-    void add_position(f32_2 position) { this->position.x += position.x; this->position.y += position.y; }
+    void add_position(f32_2 position) { this->position.x += position.x; this->position.y += position.y; update_bounding_box(); }
     void add_velocity(f32_2 velocity) { this->velocity.x += velocity.x; this->velocity.y += velocity.y; }
-    void add_angle(f32 angle) { this->angle += angle; }
+    void add_angle(f32 angle) { this->angle += angle; outline_dirty = true; }
     void add_angular_velocity(f32 angular_velocity) { this->angular_velocity += angular_velocity; }
 
-    usize get_entity_vtx_count() const { return shape->data().vtx_count + 1; }
+    ShapeId get_shape_id() const { return shape_id; }
+    usize get_entity_vtx_count() const { return ShapeLibrary::shared().get_vtx_count(shape_id) + 1; }
 
-    const f32_2* get_entity_vtx_array() {
+    /**
+     * @brief Get the world space outline, rebuilding it first if outdated.
+     */
+    const f32_2* get_entity_vtx_array() const {
+        update_outline();
         return rel_vertexes;
     }
 
+    /**
+     * @brief Get the tight bounding box of the world space outline, rebuilding it first if outdated.
+     */
+    const f32_2* get_outline_bounding_box() const {
+        update_outline();
+        return outline_bounding_box;
+    }
+
+    /**
+     * @brief Rebuild the world space outline now, if outdated, instead of on its first read.
+     * @note The outline is rebuilt lazily through const getters, so an entity read from several threads at once
+     * must be prepared first, or the threads would race to rebuild it.
+     */
+    void prepare_outline() const { update_outline(); }
+
+    /**
+     * @brief Keep the current position and angle as the previous state, which rendering interpolates from.
+     * @note Setting the position or angle directly also resets the previous state, so that teleports aren't
+     * interpolated.
+     */
+    void store_previous_pose() {
+        previous_position = position;
+        previous_angle = angle;
+    }
+
+    /**
+     * @brief Build the world space outline at a pose between the previous state and the current one.
+     * @param alpha 0 for the previous state, 1 for the current one.
+     * @param out Room for get_entity_vtx_count() vertexes.
+     * @return The outline, written to out.
+     */
+    const f32_2* get_interpolated_vtx_array(f32 alpha, f32_2* out) const {
+        const ShapeLibrary& library = ShapeLibrary::shared();
+        const f32 lerp_angle = previous_angle + (angle - previous_angle) * alpha;
+        f32 sin_angle, cos_angle;
+        f32_2 bbox[2];
+
+        ltsincosf(lerp_angle, sin_angle, cos_angle);
+
+        const VertexKernel::Job job = {
+            library.load_vertexes(shape_id, out), library.get_vtx_count(shape_id),
+            { previous_position.x + (position.x - previous_position.x) * alpha, previous_position.y + (position.y - previous_position.y) * alpha },
+            sin_angle, cos_angle, out, bbox
+        };
+
+        VertexKernel::transform(&job, 1);
+        return out;
+    }
+
+    /**
+     * @brief Get the entity as seen by the Narrowphase, rebuilding the outline first if outdated.
+     */
+    Narrowphase::Body get_body() const {
+        update_outline();
+        return { shape_id, rel_vertexes, position, outline_sin_angle, outline_cos_angle };
+    }
+
     void step(f32 dt_scale) {
         position.x += velocity.x * dt_scale;
         position.y += velocity.y * dt_scale;
@@ -115,46 +163,79 @@ public:
 
         update_bounding_box();
         //DrawRectangleLines(bounding_box[0].x, bounding_box[0].y, bounding_box[1].x - bounding_box[0].x, bounding_box[1].y - bounding_box[0].y, RED);
-    
-        const usize vtx_count = shape->data().vtx_count;
-        const f32_2* vertexes = shape->data().vertexes;
-
-        float sin_angle = ltsinf(angle);
-        float cos_angle = ltcosf(angle);
-
-        for (usize i = 0; i < vtx_count; ++i) {
-            float rx = vertexes[i].x * cos_angle - vertexes[i].y * sin_angle;
-            float ry = vertexes[i].x * sin_angle + vertexes[i].y * cos_angle;
-            rel_vertexes[i] = { rx + position.x, ry + position.y };
-        }
-        
-        rel_vertexes[vtx_count] = rel_vertexes[0];
     }
 
-    bool is_collision(const Entity& other) const {
+    /**
+     * @brief Check if this entity collides with another one, by bounding circle, bounding box and then Narrowphase.
+     * @param other The other entity.
+     * @param contact If not null, filled with the contact when the entities collide, with the normal pointing
+     * towards the other entity.
+     * @return Whether the entities collide.
+     */
+    bool is_collision(const Entity& other, Narrowphase::Contact* contact = nullptr) const {
         if (this == &other)
             return false;
 
-        bool bounding_box_collision = (
-            bounding_box[0].x < other.bounding_box[1].x and
-            bounding_box[1].x > other.bounding_box[0].x and
-            bounding_box[0].y < other.bounding_box[1].y and
-            bounding_box[1].y > other.bounding_box[0].y
-        );
+        const ShapeLibrary& library = ShapeLibrary::shared();
 
-        if (!bounding_box_collision)
+        if (!is_circle_overlap(position, library.get_radius(shape_id), other.position, library.get_radius(other.shape_id)))
             return false;
+        if (!is_overlap(bounding_box, other.bounding_box))
+            return false;
+        if (!is_overlap(get_outline_bounding_box(), other.get_outline_bounding_box()))
+            return false;
+
+        return Narrowphase::collide(get_body(), other.get_body(), contact);
+    }
+
+    /**
+     * @brief Check if two bounding circles overlap, the cheapest rejection test between two entities.
+     */
+    static bool is_circle_overlap(f32_2 pos_a, f32 radius_a, f32_2 pos_b, f32 radius_b) {
+        const f32 dx = pos_b.x - pos_a.x;
+        const f32 dy = pos_b.y - pos_a.y;
+        const f32 radius = radius_a + radius_b;
 
-        const usize vtx_count[2] = { shape->data().vtx_count, other.shape->data().vtx_count };
-        const f32_2* vertexes[2] = { shape->data().vertexes, other.shape->data().vertexes };
+        return dx * dx + dy * dy < radius * radius;
+    }
+
+    /**
+     * @brief Check if two bounding boxes overlap.
+     */
+    static bool is_overlap(const f32_2* bbox_a, const f32_2* bbox_b) {
+        return (
+            bbox_a[0].x < bbox_b[1].x and
+            bbox_a[1].x > bbox_b[0].x and
+            bbox_a[0].y < bbox_b[1].y and
+            bbox_a[1].y > bbox_b[0].y
+        );
+    }
+
+    /**
+     * @brief Check if two closed outlines cross, first by bounding box, then by testing every pair of edges.
+     *
+     * This was the narrowphase before the separating axis one, and is kept as a baseline for the benchmarks. It
+     * costs up to n_a * n_b segment tests, and misses an outline sitting entirely inside the other one.
+     *
+     * @param bbox_a The bounding box of the first outline.
+     * @param vtx_a The vertexes of the first outline, with the first vertex repeated at position n_a.
+     * @param n_a The amount of vertexes of the first outline, not counting the repeated one.
+     * @param bbox_b The bounding box of the second outline.
+     * @param vtx_b The vertexes of the second outline, with the first vertex repeated at position n_b.
+     * @param n_b The amount of vertexes of the second outline, not counting the repeated one.
+     * @return Whether the outlines cross.
+     */
+    static bool is_outline_intersection(const f32_2* bbox_a, const f32_2* vtx_a, usize n_a, const f32_2* bbox_b, const f32_2* vtx_b, usize n_b) {
+        if (!is_overlap(bbox_a, bbox_b))
+            return false;
 
-        for (usize i = 0; i < vtx_count[0]; ++i) {
-            const f32_2 p1 = rel_vertexes[i];
-            const f32_2 p2 = rel_vertexes[i + 1];
+        for (usize i = 0; i < n_a; ++i) {
+            const f32_2 p1 = vtx_a[i];
+            const f32_2 p2 = vtx_a[i + 1];
 
-            for (usize j = 0; j < vtx_count[1]; ++j) {
-                const f32_2 q1 = other.rel_vertexes[j];
-                const f32_2 q2 = other.rel_vertexes[j + 1];
+            for (usize j = 0; j < n_b; ++j) {
+                const f32_2 q1 = vtx_b[j];
+                const f32_2 q2 = vtx_b[j + 1];
 
                 if (ccw(p1, q1, q2) != ccw(p2, q1, q2) and ccw(p1, p2, q1) != ccw(p1, p2, q2))
                     return true;
@@ -0,0 +1,120 @@
+#ifndef ENTITYSHAPE_HPP_
+#define ENTITYSHAPE_HPP_
+
+#include <algorithm>
+#include <cmath>
+
+#include "typedef.hpp"
+
+/**
+ * @brief Base class for all entity vector shapes.
+ *
+ * The EntityShape struct provides a base for all entities that have a shape made up of vertexes.
+ * It has a maximum amount of vertexes and a count of how many are actually used.
+ *
+ * This struct owns the vertexes array, and is used to build shapes before copying them into the ShapeLibrary.
+ * Once the vertexes are set, update_metadata() caches the values every consumer would otherwise recompute: the
+ * bounding radius, the centroid, the signed area, whether the outline is convex, and the outward edge normals.
+ *
+ * @note To change the point coordinates (like for relative position or rotation), use the Entity's rel_vertexes array.
+ */
+class EntityShape {
+public:
+    static constexpr usize MAX_VERTEXES = 31;
+
+    struct Metadata {
+        f32 radius; // Largest vertex distance from the rotation center, slightly padded for rounding.
+        f32_2 centroid;
+        f32 area; // Signed, positive when the shoelace sum of the outline is positive.
+        bool convex;
+    };
+
+private:
+    struct EntityShapeData {
+        usize vtx_count;
+        f32_2* vertexes;
+    };
+
+    struct EntityShapeDataConst {
+        const usize vtx_count;
+        const f32_2* vertexes;
+    };
+
+    usize vtx_count;
+    f32_2 vertexes[MAX_VERTEXES];
+    f32_2 normals[MAX_VERTEXES]; // Edge i goes from vertex i to vertex i + 1, wrapping around.
+    Metadata metadata;
+
+public:
+    EntityShapeData data() { return { vtx_count, vertexes }; }
+    EntityShapeDataConst data() const { return { vtx_count, vertexes }; }
+
+    const Metadata& get_metadata() const { return metadata; }
+    const f32_2* get_normals() const { return normals; }
+
+    EntityShape(usize vtx_count = 0) : vtx_count(vtx_count), metadata({ 0.0f, VECTOR2ZERO, 0.0f, false }) {}
+    EntityShape(usize vtx_count, const f32_2* vertexes) : vtx_count(vtx_count) {
+        for (usize i = 0; i < vtx_count; ++i)
+            this->vertexes[i] = vertexes[i];
+        update_metadata();
+    }
+    EntityShape(const EntityShapeData& data) : vtx_count(data.vtx_count) {
+        for (usize i = 0; i < vtx_count; ++i)
+            vertexes[i] = data.vertexes[i];
+        update_metadata();
+    }
+
+    /**
+     * @brief Compute the cached metadata and edge normals from the current vertexes.
+     * @note Shapes that fill their vertexes after construction must call this once they are done.
+     */
+    void update_metadata() {
+        f32 radius2 = 0.0f;
+        f32 area2 = 0.0f;
+        f32_2 centroid_sum = VECTOR2ZERO;
+        f32_2 vertex_sum = VECTOR2ZERO;
+        usize positive_turns = 0;
+        usize negative_turns = 0;
+
+        for (usize i = 0; i < vtx_count; ++i) {
+            const f32_2 a = vertexes[i];
+            const f32_2 b = vertexes[(i + 1) % vtx_count];
+            const f32_2 c = vertexes[(i + 2) % vtx_count];
+            const f32 cross = a.x * b.y - b.x * a.y;
+            const f32 turn = (b.x - a.x) * (c.y - b.y) - (b.y - a.y) * (c.x - b.x);
+
+            radius2 = std::max(radius2, a.x * a.x + a.y * a.y);
+            area2 += cross;
+            centroid_sum.x += (a.x + b.x) * cross;
+            centroid_sum.y += (a.y + b.y) * cross;
+            vertex_sum.x += a.x;
+            vertex_sum.y += a.y;
+            positive_turns += turn > 0.0f;
+            negative_turns += turn < 0.0f;
+        }
+
+        metadata.radius = std::sqrt(radius2) * 1.0001f;
+        metadata.area = area2 / 2.0f;
+        metadata.convex = vtx_count >= 3 and (positive_turns == 0 or negative_turns == 0);
+
+        if (std::fabs(area2) > 1e-6f)
+            metadata.centroid = { centroid_sum.x / (3.0f * area2), centroid_sum.y / (3.0f * area2) };
+        else if (vtx_count > 0)
+            metadata.centroid = { vertex_sum.x / vtx_count, vertex_sum.y / vtx_count };
+        else
+            metadata.centroid = VECTOR2ZERO;
+
+        const f32 outward = area2 < 0.0f ? -1.0f : 1.0f;
+
+        for (usize i = 0; i < vtx_count; ++i) {
+            const f32_2 a = vertexes[i];
+            const f32_2 b = vertexes[(i + 1) % vtx_count];
+            const f32_2 edge = { b.x - a.x, b.y - a.y };
+            const f32 length = std::sqrt(edge.x * edge.x + edge.y * edge.y);
+
+            normals[i] = length > 0.0f ? f32_2{ outward * edge.y / length, -outward * edge.x / length } : VECTOR2ZERO;
+        }
+    }
+};
+
+#endif
\ No newline at end of file
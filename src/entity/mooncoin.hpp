@@ -1,6 +1,8 @@
 #ifndef MOONCOIN_HPP_
 #define MOONCOIN_HPP_
 
+#include <type_traits>
+
 #include "typedef.hpp"
 #include "entity.hpp"
 
@@ -36,20 +38,19 @@ struct MooncoinShape : public EntityShape {
         vertexes[16] = { 12.0f, 20.0f };
     }
 
-    MooncoinShape() : EntityShape(17) { init_shape(); }
+    MooncoinShape() : EntityShape(17) { init_shape(); update_metadata(); }
 };
 
 /**
  * @brief A mooncoin entity.
  */
 class Mooncoin : public Entity {
-private:
-    MooncoinShape shape;
-
 public:
     static constexpr f32 RECOVERY_AMOUNT = 100.0f;
 
-    Mooncoin() : Entity(&shape) {}
+    Mooncoin() : Entity(ShapeLibrary::shared().get_mooncoin()) {}
 };
 
+static_assert(std::is_trivially_copyable<Mooncoin>::value, "Mooncoin must stay trivially copyable, shapes belong to the ShapeLibrary.");
+
 #endif
\ No newline at end of file
@@ -0,0 +1,155 @@
+#ifndef NARROWPHASE_HPP_
+#define NARROWPHASE_HPP_
+
+#include "typedef.hpp"
+#include "shapelibrary.hpp"
+
+/**
+ * @brief Separating axis collision test between two shapes of the ShapeLibrary.
+ *
+ * Each shape is split into convex pieces by the library, so two shapes collide when any piece of one overlaps any
+ * piece of the other. Two convex pieces overlap unless one of them lies entirely in front of an edge of the other,
+ * which also catches a piece sitting entirely inside another one. The smallest overlap along the edge normals is
+ * the penetration depth.
+ *
+ * The pieces are tested on the world space outline already built for the entity, with the edge normals rotated
+ * by the same angle. Pairs of pieces whose bounding circles don't overlap are skipped. When only the answer is
+ * asked for, pairs whose inner circles overlap collide without testing any axis, which settles most touching pairs
+ * of small asteroids (a single piece each) for about the cost of the edge test it replaced.
+ */
+namespace Narrowphase {
+    /**
+     * @brief How two colliding shapes touch.
+     *
+     * Moving the second shape by normal * depth separates the deepest overlapping pair of pieces.
+     */
+    struct Contact {
+        f32_2 normal; // Unit length, pointing from the first shape to the second one.
+        f32 depth;
+    };
+
+    /**
+     * @brief A shape placed in the world, as seen by the narrowphase.
+     */
+    struct Body {
+        ShapeId shape_id;
+        const f32_2* vertexes; // The world space outline.
+        f32_2 position;
+        f32 sin_angle;
+        f32 cos_angle;
+
+        f32_2 rotate(f32_2 v) const { return { v.x * cos_angle - v.y * sin_angle, v.y * cos_angle + v.x * sin_angle }; }
+        f32_2 to_world(f32_2 v) const { const f32_2 r = rotate(v); return { r.x + position.x, r.y + position.y }; }
+    };
+
+    /**
+     * @brief Find how deep a convex piece reaches behind the edges of another one.
+     *
+     * For every edge of piece pa, the deepest vertex of piece pb along the inward edge normal gives the overlap on
+     * that axis, and the edge vertex itself gives the extent of pa, so only pb has to be projected.
+     *
+     * @return False as soon as a separating edge is found, otherwise the smallest overlap is kept in depth and axis.
+     */
+    inline bool min_depth(const ShapeLibrary& library, const Body& a, const ShapeLibrary::ConvexPiece& pa, const Body& b, const ShapeLibrary::ConvexPiece& pb, f32& depth, f32_2& axis) {
+        const u8* idx_a = library.get_piece_vertexes(pa);
+        const u8* idx_b = library.get_piece_vertexes(pb);
+        const f32_2* normals = library.get_piece_normals(pa);
+
+        for (usize i = 0; i < pa.count; ++i) {
+            if (normals[i].x == 0.0f and normals[i].y == 0.0f)
+                continue;
+
+            const f32_2 n = a.rotate(normals[i]);
+            const f32_2 v = a.vertexes[idx_a[i]];
+            const f32 extent = v.x * n.x + v.y * n.y;
+            f32 reach = b.vertexes[idx_b[0]].x * n.x + b.vertexes[idx_b[0]].y * n.y;
+
+            for (usize j = 1; j < pb.count; ++j) {
+                const f32 d = b.vertexes[idx_b[j]].x * n.x + b.vertexes[idx_b[j]].y * n.y;
+                reach = d < reach ? d : reach;
+            }
+
+            const f32 overlap = extent - reach;
+            if (overlap <= 0.0f)
+                return false;
+
+            if (overlap < depth) {
+                depth = overlap;
+                axis = n;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Check if two shapes collide.
+     * @param a The first shape.
+     * @param b The second shape.
+     * @param contact If not null, filled with the deepest contact when the shapes collide. Passing null lets the
+     * test return at the first overlapping pair of pieces.
+     * @return Whether the shapes collide.
+     */
+    inline bool collide(const Body& a, const Body& b, Contact* contact = nullptr) {
+        const ShapeLibrary& library = ShapeLibrary::shared();
+        const ShapeLibrary::ConvexPiece* pieces_a = library.get_pieces(a.shape_id);
+        const ShapeLibrary::ConvexPiece* pieces_b = library.get_pieces(b.shape_id);
+        const usize count_a = library.get_piece_count(a.shape_id);
+        const usize count_b = library.get_piece_count(b.shape_id);
+
+        // At worst a shape is cut into the triangles of its outline, so there are fewer pieces than vertexes.
+        f32_2 centers_a[EntityShape::MAX_VERTEXES];
+        f32_2 centers_b[EntityShape::MAX_VERTEXES];
+
+        for (usize i = 0; i < count_a; ++i)
+            centers_a[i] = a.to_world(pieces_a[i].center);
+        for (usize j = 0; j < count_b; ++j)
+            centers_b[j] = b.to_world(pieces_b[j].center);
+
+        // Overlapping inner circles settle the answer without the axes, so they are all tried before any of them.
+        if (!contact) {
+            for (usize i = 0; i < count_a; ++i) {
+                for (usize j = 0; j < count_b; ++j) {
+                    const f32_2 delta = { centers_b[j].x - centers_a[i].x, centers_b[j].y - centers_a[i].y };
+                    const f32 inner_radius = pieces_a[i].inner_radius + pieces_b[j].inner_radius;
+
+                    if (delta.x * delta.x + delta.y * delta.y < inner_radius * inner_radius)
+                        return true;
+                }
+            }
+        }
+
+        bool hit = false;
+
+        for (usize i = 0; i < count_a; ++i) {
+            for (usize j = 0; j < count_b; ++j) {
+                const f32_2 delta = { centers_b[j].x - centers_a[i].x, centers_b[j].y - centers_a[i].y };
+                const f32 radius = pieces_a[i].radius + pieces_b[j].radius;
+
+                if (delta.x * delta.x + delta.y * delta.y >= radius * radius)
+                    continue;
+
+                f32 depth = radius;
+                f32_2 axis = VECTOR2ZERO;
+
+                if (!min_depth(library, a, pieces_a[i], b, pieces_b[j], depth, axis) or !min_depth(library, b, pieces_b[j], a, pieces_a[i], depth, axis))
+                    continue;
+
+                if (!contact)
+                    return true;
+
+                if (!hit or depth > contact->depth) {
+                    const bool flip = delta.x * axis.x + delta.y * axis.y < 0.0f;
+                    contact->normal = flip ? f32_2{ -axis.x, -axis.y } : axis;
+                    contact->depth = depth;
+                }
+
+                hit = true;
+            }
+        }
+
+        return hit;
+    }
+};
+
+#endif
\ No newline at end of file
@@ -1,9 +1,13 @@
 #ifndef ROVER_HPP_
 #define ROVER_HPP_
 
+#include <cmath>
+#include <type_traits>
+
 #include "typedef.hpp"
 #include "entity.hpp"
 #include "ltmath.hpp"
+#include "util.hpp"
 
 using namespace LookupTableMath;
 
@@ -24,7 +28,16 @@ struct RoverShape : public EntityShape {
         vertexes[5] = { 16.0f, -4.0f };
     }
 
-    RoverShape() : EntityShape(6) { init_shape(); }
+    RoverShape() : EntityShape(6) { init_shape(); update_metadata(); }
+};
+
+/**
+ * @brief The state of the rover controls for a single step.
+ */
+struct RoverInput {
+    bool forward;
+    bool left;
+    bool right;
 };
 
 /**
@@ -32,27 +45,31 @@ struct RoverShape : public EntityShape {
  */
 class Rover : public Entity {
 private:
-    RoverShape shape;
     f32_2 triangle_pair[6];
     f32 health;
 
 public:
     static constexpr f32 DEFAULT_MAX_HEALTH = 1000.0f;
+    static constexpr f32 MAX_VELOCITY = 9.0f;
+    static constexpr f32 MAX_ANGULAR_VELOCITY = 0.1f;
+    static constexpr f32 VELOCITY_DAMPING = 0.98f; // Velocity kept after a step of dt_scale 1 with released controls.
 
     enum Direction {
         UP, DOWN, LEFT, RIGHT
     };
 
-    Rover(f32 health = DEFAULT_MAX_HEALTH) : Entity(&shape), health(health) {}
+    Rover(f32 health = DEFAULT_MAX_HEALTH) : Entity(ShapeLibrary::shared().get_rover()), health(health) {}
 
     f32 get_health() const { return health; }
     void set_health(f32 health) { this->health = health; }
     void add_health(f32 health) { this->health += health; }
 
     void add_velocity_forward(f32 velocity_mod) {
-        const f32 fwd_angle = angle - M_PI / 2.0f;
+        f32 sin_angle, cos_angle;
 
-        add_velocity({ velocity_mod * ltcosf(fwd_angle), velocity_mod * ltsinf(fwd_angle) });
+        // Forward is a quarter turn behind the angle, whose cosine and sine are the sine and minus the cosine.
+        ltsincosf(angle, sin_angle, cos_angle);
+        add_velocity({ velocity_mod * sin_angle, -velocity_mod * cos_angle });
     }
 
     void dampen_velocity(f32 dampening) {
@@ -64,9 +81,44 @@ public:
         angular_velocity *= dampening;
     }
 
+    /**
+     * @brief Apply the player controls, with damping on released controls and velocity limits.
+     *
+     * The damping is raised to the power of dt_scale, so a step of 2 damps as much as two steps of 1.
+     *
+     * @param input The controls held during this step.
+     * @param dt_scale The delta time scaling for this step.
+     */
+    void apply_input(const RoverInput& input, f32 dt_scale) {
+        if (input.forward)
+            add_velocity_forward(0.21f * dt_scale);
+        if (input.left)
+            add_angular_velocity(-0.003f * dt_scale);
+        if (input.right)
+            add_angular_velocity(0.003f * dt_scale);
+
+        const f32 damping = std::pow(VELOCITY_DAMPING, dt_scale);
+
+        if (!input.forward)
+            dampen_velocity(damping);
+        if (!input.left and !input.right)
+            dampen_angular_velocity(damping);
+
+        util::clamp_lh(velocity.x, -MAX_VELOCITY, MAX_VELOCITY);
+        util::clamp_lh(velocity.y, -MAX_VELOCITY, MAX_VELOCITY);
+        util::clamp_lh(angular_velocity, -MAX_ANGULAR_VELOCITY, MAX_ANGULAR_VELOCITY);
+    }
+
     const f32_2* get_triangle_pair(Direction direction) {
-        const f32_2* vtx = rel_vertexes;
+        return get_triangle_pair(direction, get_entity_vtx_array());
+    }
 
+    /**
+     * @brief Get the pair of triangles filling one side of the rover, from an outline built by the caller.
+     * @param direction The side to fill.
+     * @param vtx The rover outline, such as one from get_interpolated_vtx_array().
+     */
+    const f32_2* get_triangle_pair(Direction direction, const f32_2* vtx) {
         switch (direction) {
         case UP:
             triangle_pair[0] = vtx[0];
@@ -106,4 +158,6 @@ public:
     }
 };
 
+static_assert(std::is_trivially_copyable<Rover>::value, "Rover must stay trivially copyable, shapes belong to the ShapeLibrary.");
+
 #endif
\ No newline at end of file
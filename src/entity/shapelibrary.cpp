@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "shapelibrary.hpp"
+#include "entity.hpp"
+#include "asteroid.hpp"
+#include "mooncoin.hpp"
+#include "rover.hpp"
+
+namespace {
+    typedef std::vector<u8> Polygon;
+
+    f32 turn(const f32_2& a, const f32_2& b, const f32_2& c) {
+        return (b.x - a.x) * (c.y - b.y) - (b.y - a.y) * (c.x - b.x);
+    }
+
+    bool is_inside_triangle(const f32_2& p, const f32_2& a, const f32_2& b, const f32_2& c) {
+        return turn(a, b, p) >= 0.0f and turn(b, c, p) >= 0.0f and turn(c, a, p) >= 0.0f;
+    }
+
+    bool is_convex(const f32_2* vertexes, const Polygon& polygon) {
+        const usize n = polygon.size();
+
+        for (usize i = 0; i < n; ++i)
+            if (turn(vertexes[polygon[i]], vertexes[polygon[(i + 1) % n]], vertexes[polygon[(i + 2) % n]]) < 0.0f)
+                return false;
+
+        return true;
+    }
+
+    /*
+     * Ear clipping, for an outline with positive area. If no ear can be found, the outline is degenerate, and
+     * whatever is left is kept as a single piece.
+     */
+    std::vector<Polygon> triangulate(const f32_2* vertexes, Polygon polygon) {
+        std::vector<Polygon> triangles;
+
+        while (polygon.size() > 3) {
+            const usize n = polygon.size();
+            bool clipped = false;
+
+            for (usize i = 0; i < n and !clipped; ++i) {
+                const u8 a = polygon[(i + n - 1) % n];
+                const u8 b = polygon[i];
+                const u8 c = polygon[(i + 1) % n];
+
+                if (turn(vertexes[a], vertexes[b], vertexes[c]) <= 0.0f)
+                    continue;
+
+                bool ear = true;
+                for (usize j = 0; j < n and ear; ++j) {
+                    const u8 p = polygon[j];
+                    ear = p == a or p == b or p == c or !is_inside_triangle(vertexes[p], vertexes[a], vertexes[b], vertexes[c]);
+                }
+
+                if (ear) {
+                    triangles.push_back({ a, b, c });
+                    polygon.erase(polygon.begin() + i);
+                    clipped = true;
+                }
+            }
+
+            if (!clipped)
+                break;
+        }
+
+        triangles.push_back(polygon);
+        return triangles;
+    }
+
+    /*
+     * Join two pieces along their shared edge, which runs a -> b in the first piece and b -> a in the second one.
+     * Returns an empty polygon if the pieces don't share an edge.
+     */
+    Polygon join(const Polygon& p, const Polygon& q) {
+        const usize np = p.size();
+        const usize nq = q.size();
+
+        for (usize i = 0; i < np; ++i) {
+            for (usize j = 0; j < nq; ++j) {
+                if (q[j] != p[(i + 1) % np] or q[(j + 1) % nq] != p[i])
+                    continue;
+
+                Polygon joined;
+                for (usize k = 0; k < np; ++k)
+                    joined.push_back(p[(i + 1 + k) % np]);
+                for (usize k = 2; k < nq; ++k)
+                    joined.push_back(q[(j + k) % nq]);
+
+                return joined;
+            }
+        }
+
+        return Polygon();
+    }
+
+    /*
+     * Hertel-Mehlhorn: drop the diagonals between pieces whenever the joined piece is still convex.
+     */
+    std::vector<Polygon> merge_convex(const f32_2* vertexes, std::vector<Polygon> pieces) {
+        for (bool merged = true; merged;) {
+            merged = false;
+
+            for (usize p = 0; p < pieces.size() and !merged; ++p) {
+                for (usize q = p + 1; q < pieces.size() and !merged; ++q) {
+                    const Polygon joined = join(pieces[p], pieces[q]);
+
+                    if (!joined.empty() and is_convex(vertexes, joined)) {
+                        pieces[p] = joined;
+                        pieces.erase(pieces.begin() + q);
+                        merged = true;
+                    }
+                }
+            }
+        }
+
+        return pieces;
+    }
+}
+
+bool ShapeLibrary::shared_built = false;
+u64 ShapeLibrary::shared_seed = Rng::DEFAULT_SEED;
+
+ShapeLibrary::ShapeLibrary(u64 seed) {
+    rover_id = add(RoverShape());
+    mooncoin_id = add(MooncoinShape());
+
+    first_asteroid_id = size();
+    for (usize i = 0; i < ASTEROID_VARIANTS; ++i) {
+        Rng rng(seed, Rng::stream(Rng::SHAPE_STREAM, i));
+        const usize vtx_count = rng.next_i32(6, AsteroidShape::MAX_VERTEXES);
+        add(AsteroidShape(vtx_count, rng.next_f32(AsteroidShape::MIN_SCALE, AsteroidShape::MAX_SCALE), rng));
+    }
+}
+
+// Only called while the shared library is built, so the flag is written once, by the thread that builds it.
+u64 ShapeLibrary::take_shared_seed() {
+    shared_built = true;
+    return shared_seed;
+}
+
+ShapeLibrary& ShapeLibrary::shared() {
+    static ShapeLibrary library(take_shared_seed());
+    return library;
+}
+
+void ShapeLibrary::set_shared_seed(u64 seed) {
+    if (shared_built and seed != shared_seed)
+        throw std::runtime_error("ShapeLibrary::set_shared_seed cannot change the seed: the shared library is already built.");
+
+    shared_seed = seed;
+}
+
+ShapeId ShapeLibrary::add(const EntityShape& shape) {
+    const usize vtx_count = shape.data().vtx_count;
+    const f32_2* src = shape.data().vertexes;
+
+    vtx_offsets.push_back(vertexes.size());
+    vtx_counts.push_back(vtx_count);
+
+    for (usize i = 0; i < vtx_count; ++i) {
+#ifdef QUANTIZE_SHAPES
+        const f32 qx = std::round(src[i].x * QUANTIZE_SCALE);
+        const f32 qy = std::round(src[i].y * QUANTIZE_SCALE);
+
+        if (qx < -32768.0f or qx > 32767.0f or qy < -32768.0f or qy > 32767.0f)
+            throw std::runtime_error("ShapeLibrary::add cannot quantize shape: vertex is out of the 16 bit range.");
+
+        vertexes.push_back({ static_cast<i16>(qx), static_cast<i16>(qy) });
+#else
+        vertexes.push_back(src[i]);
+#endif
+    }
+
+    // Quantizing moves the vertexes a little, so the metadata is computed again from the stored ones.
+    f32_2 scratch[EntityShape::MAX_VERTEXES];
+    const EntityShape stored(vtx_count, load_vertexes(vtx_counts.size() - 1, scratch));
+
+    metadata.push_back(stored.get_metadata());
+    normals.insert(normals.end(), stored.get_normals(), stored.get_normals() + vtx_count);
+    add_pieces(vtx_count, stored.data().vertexes, stored.get_metadata());
+
+    return vtx_counts.size() - 1;
+}
+
+void ShapeLibrary::add_pieces(usize vtx_count, const f32_2* vertexes, const EntityShape::Metadata& metadata) {
+    Polygon outline(vtx_count);
+    for (usize i = 0; i < vtx_count; ++i)
+        outline[i] = metadata.area < 0.0f ? vtx_count - 1 - i : i;
+
+    const std::vector<Polygon> convex_pieces = metadata.convex
+        ? std::vector<Polygon>(1, outline)
+        : merge_convex(vertexes, triangulate(vertexes, outline));
+
+    piece_offsets.push_back(pieces.size());
+    piece_counts.push_back(convex_pieces.size());
+
+    for (const Polygon& polygon : convex_pieces) {
+        const usize n = polygon.size();
+        ConvexPiece piece = { static_cast<u32>(piece_vertexes.size()), static_cast<u32>(n), VECTOR2ZERO, 0.0f, 0.0f };
+
+        for (usize i = 0; i < n; ++i) {
+            piece.center.x += vertexes[polygon[i]].x / n;
+            piece.center.y += vertexes[polygon[i]].y / n;
+        }
+
+        f32 radius2 = 0.0f;
+        f32 inner_radius = std::numeric_limits<f32>::max();
+
+        for (usize i = 0; i < n; ++i) {
+            const f32_2 a = vertexes[polygon[i]];
+            const f32_2 b = vertexes[polygon[(i + 1) % n]];
+            const f32_2 edge = { b.x - a.x, b.y - a.y };
+            const f32 length = std::sqrt(edge.x * edge.x + edge.y * edge.y);
+            const f32_2 offset = { a.x - piece.center.x, a.y - piece.center.y };
+
+            // The center of a convex piece is inside of it, so its distance to every edge line bounds the inner circle.
+            if (length > 0.0f)
+                inner_radius = std::min(inner_radius, std::fabs(offset.x * edge.y - offset.y * edge.x) / length);
+
+            radius2 = std::max(radius2, offset.x * offset.x + offset.y * offset.y);
+            piece_vertexes.push_back(polygon[i]);
+            piece_normals.push_back(length > 0.0f ? f32_2{ edge.y / length, -edge.x / length } : VECTOR2ZERO);
+        }
+
+        piece.radius = std::sqrt(radius2) * 1.0001f;
+        piece.inner_radius = inner_radius < std::numeric_limits<f32>::max() ? inner_radius * 0.999f : 0.0f;
+        pieces.push_back(piece);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,143 @@
+#ifndef SHAPELIBRARY_HPP_
+#define SHAPELIBRARY_HPP_
+
+#include <vector>
+
+#include "typedef.hpp"
+#include "rng.hpp"
+
+#include "entityshape.hpp"
+
+typedef u32 ShapeId;
+
+/**
+ * @brief Library of all the entity shapes, built once and shared by index.
+ *
+ * Entities don't own their shape, they keep a ShapeId into the shared library instead. The library holds a single
+ * rover shape, a single mooncoin shape and a fixed pool of randomly generated asteroid variants, with all the
+ * vertexes packed one after the other in a single pool. The metadata and edge normals of every shape are copied
+ * from its EntityShape, so they are computed only once.
+ *
+ * Every shape is also split into convex pieces when added, for the separating axis test of the Narrowphase. Convex
+ * shapes are a single piece, concave ones are triangulated by ear clipping, then neighbouring triangles are merged
+ * back together for as long as the result stays convex. Pieces refer to the shape vertexes by index, and keep their
+ * own outward edge normals, center and radius.
+ *
+ * When built with QUANTIZE_SHAPES, the vertexes are stored as 16 bit fixed point, with a step of
+ * 1 / QUANTIZE_SCALE units, which halves the pool. Use load_vertexes() to get them back as floats.
+ *
+ * The asteroid variants are drawn from the shape stream of the seed given to set_shared_seed(), one stream per
+ * variant, so every variant depends only on the seed and its own index.
+ *
+ * @note The shared library is built on first use, so set the seed before creating any entity.
+ */
+class ShapeLibrary {
+public:
+    static constexpr usize ASTEROID_VARIANTS = 256;
+    static constexpr f32 QUANTIZE_SCALE = 64.0f;
+
+    struct QuantizedVertex {
+        i16 x;
+        i16 y;
+    };
+
+    /**
+     * @brief A convex piece of a shape, with its vertexes wound so that its signed area is positive.
+     */
+    struct ConvexPiece {
+        u32 offset; // First entry of the piece in the piece vertex and normal pools.
+        u32 count;
+        f32_2 center;
+        f32 radius; // Of the smallest circle around the center holding the whole piece.
+        f32 inner_radius; // Of the largest circle around the center held entirely by the piece.
+    };
+
+private:
+#ifdef QUANTIZE_SHAPES
+    std::vector<QuantizedVertex> vertexes;
+#else
+    std::vector<f32_2> vertexes;
+#endif
+    std::vector<f32_2> normals;
+    std::vector<u32> vtx_offsets;
+    std::vector<u32> vtx_counts;
+    std::vector<EntityShape::Metadata> metadata;
+
+    std::vector<ConvexPiece> pieces;
+    std::vector<u8> piece_vertexes; // Indexes into the vertexes of the shape, edge i goes from entry i to i + 1.
+    std::vector<f32_2> piece_normals;
+    std::vector<u32> piece_offsets;
+    std::vector<u32> piece_counts;
+
+    void add_pieces(usize vtx_count, const f32_2* vertexes, const EntityShape::Metadata& metadata);
+
+    ShapeId rover_id;
+    ShapeId mooncoin_id;
+    ShapeId first_asteroid_id;
+
+    static bool shared_built;
+    static u64 shared_seed;
+
+    static u64 take_shared_seed();
+
+    explicit ShapeLibrary(u64 seed);
+
+public:
+    /**
+     * @brief Get the library shared by all entities.
+     */
+    static ShapeLibrary& shared();
+
+    /**
+     * @brief Set the seed of the asteroid variants of the shared library, before it is built.
+     */
+    static void set_shared_seed(u64 seed);
+
+    /**
+     * @brief Copy a shape into the library.
+     * @param shape The shape to copy.
+     * @return The id of the new shape.
+     */
+    ShapeId add(const EntityShape& shape);
+
+    usize size() const { return vtx_counts.size(); }
+    usize get_vtx_count(ShapeId id) const { return vtx_counts[id]; }
+
+    const EntityShape::Metadata& get_metadata(ShapeId id) const { return metadata[id]; }
+    const f32_2* get_normals(ShapeId id) const { return &normals[vtx_offsets[id]]; }
+
+    /**
+     * @brief Get the largest distance of a vertex from the shape center, enough to bound the shape at any angle.
+     */
+    f32 get_radius(ShapeId id) const { return metadata[id].radius; }
+
+    usize get_piece_count(ShapeId id) const { return piece_counts[id]; }
+    const ConvexPiece* get_pieces(ShapeId id) const { return &pieces[piece_offsets[id]]; }
+    const u8* get_piece_vertexes(const ConvexPiece& piece) const { return &piece_vertexes[piece.offset]; }
+    const f32_2* get_piece_normals(const ConvexPiece& piece) const { return &piece_normals[piece.offset]; }
+
+    /**
+     * @brief Get the vertexes of a shape as floats.
+     * @param id The shape to read.
+     * @param scratch Room for get_vtx_count(id) vertexes, only written to when the library is quantized.
+     * @return The vertexes, either straight from the library or dequantized into scratch.
+     */
+    const f32_2* load_vertexes(ShapeId id, f32_2* scratch) const {
+#ifdef QUANTIZE_SHAPES
+        const QuantizedVertex* src = &vertexes[vtx_offsets[id]];
+        for (usize i = 0; i < vtx_counts[id]; ++i)
+            scratch[i] = { src[i].x / QUANTIZE_SCALE, src[i].y / QUANTIZE_SCALE };
+        return scratch;
+#else
+        (void) scratch;
+        return &vertexes[vtx_offsets[id]];
+#endif
+    }
+
+    ShapeId get_rover() const { return rover_id; }
+    ShapeId get_mooncoin() const { return mooncoin_id; }
+    ShapeId get_asteroid(usize variant) const { return first_asteroid_id + variant % ASTEROID_VARIANTS; }
+    ShapeId get_random_asteroid(Rng& rng) const { return first_asteroid_id + rng.next_i32(0, ASTEROID_VARIANTS - 1); }
+};
+
+#endif
\ No newline at end of file
@@ -1,29 +1,70 @@
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <string>
 #include <raylib.h>
+#include <rlgl.h>
 #include "asteroid.hpp"
 #include "util.hpp"
 #include "rover.hpp"
 #include "world.hpp"
 #include "smoothcam.hpp"
+#include "linebatch.hpp"
+#include "soundbank.hpp"
+#include "fixedtimestep.hpp"
+#include "profiler.hpp"
+#include "replay.hpp"
+#include "gamerules.hpp"
 #include "ltmath.hpp"
 
 using namespace LookupTableMath;
 
-void draw(Entity* e, f32_2 offset, Color color) {
-    Vector2* vtx = const_cast<Vector2*>(e->get_entity_vtx_array());
-    util::offsetv(vtx, e->get_entity_vtx_count(), { -offset.x, -offset.y });
-    DrawLineStrip(vtx, e->get_entity_vtx_count(), color);
+void draw(const LineBatch& batch) {
+    PROFILE_ZONE("draw line batch");
+
+    // Even, so that a chunk never splits a segment, and well below the capacity of the rlgl render batch.
+    static constexpr usize SUBMIT_CHUNK = 4096;
+
+    for (usize i = 0; i < batch.get_layer_count(); ++i) {
+        const LineBatch::Layer& layer = batch.get_layer(i);
+
+        for (usize begin = 0; begin < layer.vertexes.size(); begin += SUBMIT_CHUNK) {
+            const usize end = std::min(layer.vertexes.size(), begin + SUBMIT_CHUNK);
+
+            rlCheckRenderBatchLimit(end - begin);
+            rlBegin(RL_LINES);
+            rlColor4ub(layer.color.r, layer.color.g, layer.color.b, layer.color.a);
+            for (usize v = begin; v < end; ++v)
+                rlVertex2f(layer.vertexes[v].x, layer.vertexes[v].y);
+            rlEnd();
+        }
+    }
 }
 
-void draw_fill(const f32_2* vertexes, usize vtx_count, f32_2 offset, Color color) {
-    Vector2* vtx = const_cast<Vector2*>(vertexes);
-    util::offsetv(vtx, vtx_count, { -offset.x, -offset.y });
-    DrawTriangleStrip(vtx, vtx_count, color);
+void write_trace(const char* path) {
+    try {
+        TraceLog(LOG_INFO, "Wrote %zu profiling zones to %s", Profiler::write_chrome_trace(path), path);
+    } catch (const std::exception& e) {
+        TraceLog(LOG_WARNING, "%s", e.what());
+    }
 }
 
-int main() {
-    static constexpr f32 ANIM_BASE_GAME_FPS = 60.0f;
-    static constexpr f32 MAX_ROVER_VEL = 9.0f;
-    static constexpr f32 MIN_ROVER_VEL = -MAX_ROVER_VEL;
+void save_replay(const Replay& replay, const std::string& path) {
+    try {
+        replay.save(path);
+        TraceLog(LOG_INFO, "Wrote %zu replay ticks to %s", replay.get_tick_count(), path.c_str());
+    } catch (const std::exception& e) {
+        TraceLog(LOG_WARNING, "%s", e.what());
+    }
+}
+
+int main(int argc, char** argv) {
+    static constexpr usize MAX_CATCHUP_TICKS = 5;
+    static constexpr f32 MAX_ROVER_VEL = Rover::MAX_VELOCITY;
+    static constexpr usize SFX_VOICES = 4;
+    static constexpr f64 MOONCOIN_SFX_COOLDOWN = 0.05;
+    static constexpr f64 COLLISION_SFX_COOLDOWN = 0.15;
+    static constexpr const char* TRACE_FILE = "asteroids_trace.json";
 
     // [Settings.Window]
     const f32 WINDOW_W = util::cfg_f32("Settings.Window", "WINDOW_W");
@@ -31,139 +72,198 @@ int main() {
     const usize WINDOW_FPS = util::cfg_usize("Settings.Window", "WINDOW_FPS");
     const bool WINDOW_VSYNC = util::cfg_bool("Settings.Window", "WINDOW_VSYNC");
 
+    // [Settings.World]
+    const f32 BROADPHASE_CELL_SIZE = util::cfg_f32("Settings.World", "BROADPHASE_CELL_SIZE");
+    const usize THREADS = util::cfg_usize("Settings.World", "THREADS");
+    const usize ASTEROIDS = util::cfg_usize("Settings.World", "ASTEROIDS");
+    const usize MOONCOINS = util::cfg_usize("Settings.World", "MOONCOINS");
+
+    // --record FILE saves the session on exit, --replay FILE plays one back before handing the controls over.
+    std::string record_path;
+    std::unique_ptr<Replay> playback;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string arg = argv[i];
+        if (arg == "--record")
+            record_path = argv[i + 1];
+        else if (arg == "--replay") {
+            try {
+                playback.reset(new Replay(Replay::load(argv[i + 1])));
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << "\n";
+                return 1;
+            }
+        }
+    }
+
+    const Replay::Settings session = playback ? playback->get_settings() : Replay::Settings{
+        static_cast<u32>(std::time(nullptr)),
+        static_cast<u32>(ASTEROIDS),
+        static_cast<u32>(MOONCOINS),
+        WINDOW_W,
+        WINDOW_H,
+        BROADPHASE_CELL_SIZE
+    };
+    const f32_2 viewport = { session.viewport_w, session.viewport_h };
+    Replay recording(session);
+
     SetTargetFPS(WINDOW_FPS);
     if (WINDOW_VSYNC)
         SetConfigFlags(FLAG_VSYNC_HINT);
-    InitWindow(WINDOW_W, WINDOW_H, "Extended Asteroids");
+    InitWindow(viewport.x, viewport.y, "Extended Asteroids");
 
     InitAudioDevice();
     Sound theme_bgm = LoadSound(util::cfg_string("Resources.Audio", "THEME_BGM_PATH").c_str());
     SetSoundVolume(theme_bgm, 0.5f);
 
+    // Static so that the sound callbacks can reach them, the effects are decoded here and never reloaded.
+    static SoundBank sounds;
+    static const SoundBank::Effect MOONCOIN_SFX = sounds.add(util::cfg_string("Resources.Audio", "MOONCOIN_SFX_PATH"), SFX_VOICES, MOONCOIN_SFX_COOLDOWN);
+    static const SoundBank::Effect COLLISION_SFX = sounds.add(util::cfg_string("Resources.Audio", "COLLISION_SFX_PATH"), SFX_VOICES, COLLISION_SFX_COOLDOWN);
+
+    ShapeLibrary::set_shared_seed(session.seed);
+
     World world(
         { 0.0f, 0.0f }, 
-        { WINDOW_W, WINDOW_H }, 
-        [] { PlaySound(LoadSound(util::cfg_string("Resources.Audio", "MOONCOIN_SFX_PATH").c_str())); }, 
-        [] { PlaySound(LoadSound(util::cfg_string("Resources.Audio", "COLLISION_SFX_PATH").c_str())); }
+        viewport, 
+        [] { sounds.play(MOONCOIN_SFX); }, 
+        [] { sounds.play(COLLISION_SFX); },
+        session.asteroid_count,
+        session.seed,
+        session.mooncoin_count
     );
-    world.get_rover().set_position({ WINDOW_W / 2, WINDOW_H / 2 });
+    world.get_rover().set_position({ viewport.x / 2, viewport.y / 2 });
+    if (session.broadphase_cell_size > 0.0f)
+        world.set_broadphase_cell_size(session.broadphase_cell_size);
+    if (THREADS > 0)
+        world.set_thread_count(THREADS);
 
     SmoothCamera cam({ 0.0f, 0.0f });
 
     PlaySound(theme_bgm);
 
-    double next_asteroid_spawn = GetTime();
-    double next_mooncoin_spawn = GetTime();
+    FixedTimestep clock(1.0 / World::TICK_RATE, MAX_CATCHUP_TICKS);
+    f32_2 outline[EntityShape::MAX_VERTEXES + 1];
+    LineBatch lines;
 
     while (!WindowShouldClose()) {
+        PROFILE_ZONE("frame");
+
         if (!IsSoundPlaying(theme_bgm))
             PlaySound(theme_bgm);
 
-        const f32 dt_scale = GetFrameTime() * ANIM_BASE_GAME_FPS;
-        
-        f32_2 rover_vel = world.get_rover().get_velocity();
+        const usize ticks = clock.advance(GetFrameTime());
+        sounds.set_time(GetTime());
 
-        const f32_2 centered_view_of_rover = { world.get_rover().get_position().x - WINDOW_W / 2, world.get_rover().get_position().y - WINDOW_H / 2 };
+        for (usize i = 0; i < ticks and world.get_rover().get_health() > 0.0f; ++i) {
+            PROFILE_ZONE("tick");
+            const u64 tick = clock.get_tick_count() - ticks + i;
+            const RoverInput input = playback and tick < playback->get_tick_count()
+                ? playback->get_input(tick)
+                : RoverInput{ IsKeyDown(KEY_W), IsKeyDown(KEY_A), IsKeyDown(KEY_D) };
 
-        const f32 rover_angle = world.get_rover().get_angle();
-        const f32_2 rover_fill_pos = { 
-            world.get_position().x - cam.get().x,
-            world.get_position().y - cam.get().y
-        };
+            recording.record(input);
+            GameRules::tick(world, cam, input, tick, viewport);
+        }
+
+        // Draw between the last two ticks, using how far the clock is into the next one.
+        const f32 alpha = clock.get_alpha();
+        const f32_2 view = cam.get_interpolated(alpha);
+        Rover& rover = world.get_rover();
+
+        const f32_2 rover_vel = rover.get_velocity();
+        f32 rover_sin, rover_cos;
+        ltsincosf(rover.get_angle(), rover_sin, rover_cos);
+
+        // Cosines of the angle turned by 0, PI, 3 * PI / 2 and PI / 2.
         const u8 rover_alphas[4] = {
-            static_cast<u8>((1 + ltcosf(rover_angle)) * 255.0f / 4.0f),
-            static_cast<u8>((1 + ltcosf(rover_angle + M_PI)) * 255.0f / 4.0f),
-            static_cast<u8>((1 + ltcosf(rover_angle + 3 * M_PI / 2)) * 255.0f / 4.0f),
-            static_cast<u8>((1 + ltcosf(rover_angle + M_PI / 2)) * 255.0f / 4.0f)
+            static_cast<u8>((1 + rover_cos) * 255.0f / 4.0f),
+            static_cast<u8>((1 - rover_cos) * 255.0f / 4.0f),
+            static_cast<u8>((1 + rover_sin) * 255.0f / 4.0f),
+            static_cast<u8>((1 - rover_sin) * 255.0f / 4.0f)
         };
 
         BeginDrawing();
 
         ClearBackground(Color{ 0x27, 0x28, 0x22, 0xff });
-        for (usize i = 0; i < world.get_mooncoin_count(); ++i)
-            draw(&world.get_mooncoin(i), world.get_position(), Color{ 0x00, 0xff, 0x00, 0xff });
 
-        for (usize i = 0; i < world.get_asteroid_count(); ++i)
-            draw(&world.get_asteroid(i), world.get_position(), WHITE);
+        // The entities are drawn in world space, the camera moves the view instead of their vertexes.
+        BeginMode2D(Camera2D{ { 0.0f, 0.0f }, view, 0.0f, 1.0f });
+
+        {
+            PROFILE_ZONE("build line batch");
+            lines.clear();
+            world.update_visible(view);
 
-        draw(&world.get_rover(), world.get_position(), GREEN);
+            for (usize i : world.get_visible_mooncoins()) {
+                const Mooncoin& mooncoin = world.get_mooncoin(i);
+                lines.add_strip(mooncoin.get_interpolated_vtx_array(alpha, outline), mooncoin.get_entity_vtx_count(), Color{ 0x00, 0xff, 0x00, 0xff });
+            }
+
+            for (usize i : world.get_visible_asteroids()) {
+                const AsteroidStore::Ref asteroid = world.get_asteroid(i);
+                lines.add_strip(asteroid.get_interpolated_vtx_array(alpha, outline), asteroid.get_entity_vtx_count(), WHITE);
+            }
+        }
+
+        rover.get_interpolated_vtx_array(alpha, outline);
 
         //DrawCircle(rover_fill_pos.x, rover_fill_pos.y, 50.0f, RED); // TODO for a future fuel mechanic, destroy asteroids to get circles for fuel/attacks
 
-        draw_fill(world.get_rover().get_triangle_pair(Rover::UP), 6, rover_fill_pos, Color{ 0x00, 0xff, 0x00, rover_alphas[0] });
-        draw_fill(world.get_rover().get_triangle_pair(Rover::DOWN), 6, rover_fill_pos, Color{ 0x00, 0xff, 0x00, rover_alphas[1] });
-        draw_fill(world.get_rover().get_triangle_pair(Rover::LEFT), 6, rover_fill_pos, Color{ 0x00, 0xff, 0x00, rover_alphas[2] });
-        draw_fill(world.get_rover().get_triangle_pair(Rover::RIGHT), 6, rover_fill_pos, Color{ 0x00, 0xff, 0x00, rover_alphas[3] });
+        DrawTriangleStrip(rover.get_triangle_pair(Rover::UP, outline), 6, Color{ 0x00, 0xff, 0x00, rover_alphas[0] });
+        DrawTriangleStrip(rover.get_triangle_pair(Rover::DOWN, outline), 6, Color{ 0x00, 0xff, 0x00, rover_alphas[1] });
+        DrawTriangleStrip(rover.get_triangle_pair(Rover::LEFT, outline), 6, Color{ 0x00, 0xff, 0x00, rover_alphas[2] });
+        DrawTriangleStrip(rover.get_triangle_pair(Rover::RIGHT, outline), 6, Color{ 0x00, 0xff, 0x00, rover_alphas[3] });
+        lines.add_strip(outline, rover.get_entity_vtx_count(), GREEN);
+        draw(lines);
+
+        EndMode2D();
 
         /* UI */
 
-        DrawRectangle(0, 0, WINDOW_W, 80, Color{ 0x20, 0x20, 0x20, 0xa0 });
+        DrawRectangle(0, 0, viewport.x, 80, Color{ 0x20, 0x20, 0x20, 0xa0 });
         DrawText(std::to_string(GetFPS()).c_str(), 10, 6, 40, WHITE);
 
-        DrawRectangle(0, WINDOW_H - 80, WINDOW_W, 80, Color{ 0x20, 0x20, 0x20, 0xa0 });
+        DrawRectangle(0, viewport.y - 80, viewport.x, 80, Color{ 0x20, 0x20, 0x20, 0xa0 });
 
-        DrawText("SPEED", 10, WINDOW_H - 46, 30, WHITE);
-        DrawRectangle(9, WINDOW_H - 54, 400, 6, Color{ 0x0a, 0x0a, 0x0a, 0xff });
-        DrawRectangle(9, WINDOW_H - 54, 400 * static_cast<f32>(rover_vel.x * rover_vel.x + rover_vel.y * rover_vel.y) / (MAX_ROVER_VEL * MAX_ROVER_VEL) / 2, 6, Color{ 0x00, 0xff, 0x00, 0xff });
+        DrawText("SPEED", 10, viewport.y - 46, 30, WHITE);
+        DrawRectangle(9, viewport.y - 54, 400, 6, Color{ 0x0a, 0x0a, 0x0a, 0xff });
+        DrawRectangle(9, viewport.y - 54, 400 * static_cast<f32>(rover_vel.x * rover_vel.x + rover_vel.y * rover_vel.y) / (MAX_ROVER_VEL * MAX_ROVER_VEL) / 2, 6, Color{ 0x00, 0xff, 0x00, 0xff });
 
-        DrawText("HEADING", 440, WINDOW_H - 46, 30, WHITE);
-        DrawRectangle(439, WINDOW_H - 54, 400, 6, Color{ 0x0a, 0x0a, 0x0a, 0xff });
-        DrawRectangle(439 + 200 + 199 * ltsinf(rover_angle), WINDOW_H - 54, 10, 6, Color{ 0x00, 0xff, 0x00, 0xff });
+        DrawText("HEADING", 440, viewport.y - 46, 30, WHITE);
+        DrawRectangle(439, viewport.y - 54, 400, 6, Color{ 0x0a, 0x0a, 0x0a, 0xff });
+        DrawRectangle(439 + 200 + 199 * rover_sin, viewport.y - 54, 10, 6, Color{ 0x00, 0xff, 0x00, 0xff });
 
-        DrawText("HEALTH", 870, WINDOW_H - 46, 30, WHITE);
-        DrawRectangle(869, WINDOW_H - 54, 400, 6, Color{ 0x0a, 0x0a, 0x0a, 0xff });
-        DrawRectangle(869, WINDOW_H - 54, 400 * world.get_rover().get_health() / Rover::DEFAULT_MAX_HEALTH, 6, Color{ 0x00, 0xff, 0x00, 0xff });
+        DrawText("HEALTH", 870, viewport.y - 46, 30, WHITE);
+        DrawRectangle(869, viewport.y - 54, 400, 6, Color{ 0x0a, 0x0a, 0x0a, 0xff });
+        DrawRectangle(869, viewport.y - 54, 400 * world.get_rover().get_health() / Rover::DEFAULT_MAX_HEALTH, 6, Color{ 0x00, 0xff, 0x00, 0xff });
         
-        DrawText("MOONCOINS", 1300, WINDOW_H - 54, 30, WHITE);
-        DrawText(std::to_string(world.get_collected_mooncoins()).c_str(), 1550, WINDOW_H - 76, 80, WHITE);
+        DrawText("MOONCOINS", 1300, viewport.y - 54, 30, WHITE);
+        DrawText(std::to_string(world.get_collected_mooncoins()).c_str(), 1550, viewport.y - 76, 80, WHITE);
 
-        if (world.get_rover().get_health() <= 0.0f) {
-            DrawText("GAME OVER", WINDOW_W / 2 - 100, WINDOW_H / 2 - 50, 50, WHITE);
-            EndDrawing();
-            continue;
-        }
+        if (world.get_rover().get_health() <= 0.0f)
+            DrawText("GAME OVER", viewport.x / 2 - 100, viewport.y / 2 - 50, 50, WHITE);
 
-        EndDrawing();
-
-        if (IsKeyDown(KEY_W))
-            world.get_rover().add_velocity_forward(0.21f * dt_scale);
-        if (IsKeyDown(KEY_A))
-            world.get_rover().add_angular_velocity(-0.003f * dt_scale);
-        if (IsKeyDown(KEY_D))
-            world.get_rover().add_angular_velocity(0.003f * dt_scale);
-
-        if (!IsKeyDown(KEY_W))
-            world.get_rover().dampen_velocity(0.98f); // TODO this is an issue for delta time scaling
-        if (!IsKeyDown(KEY_A) and !IsKeyDown(KEY_D))
-            world.get_rover().dampen_angular_velocity(0.98f);
-
-        rover_vel = world.get_rover().get_velocity();
-        f32 rover_angular_vel = world.get_rover().get_angular_velocity();
-        util::clamp_lh(rover_vel.x, MIN_ROVER_VEL, MAX_ROVER_VEL);
-        util::clamp_lh(rover_vel.y, MIN_ROVER_VEL, MAX_ROVER_VEL);
-        util::clamp_lh(rover_angular_vel, -0.1f, 0.1f);
-        world.get_rover().set_velocity(rover_vel);
-        world.get_rover().set_angular_velocity(rover_angular_vel);
-
-        cam.target(centered_view_of_rover);
-        world.step(dt_scale);
-        cam.step(dt_scale);
-        world.set_position(cam.get());
-
-        world.get_rover().add_health(-0.15f * dt_scale);
-
-        if (GetTime() > next_asteroid_spawn + 1.55f) {
-            world.spawn_asteroid_nearby(centered_view_of_rover, 2400.0f);
-            next_asteroid_spawn = GetTime();
+        {
+            PROFILE_ZONE("EndDrawing");
+            EndDrawing();
         }
 
-        if (GetTime() > next_mooncoin_spawn + 0.75f) {
-            world.spawn_mooncoin_nearby(centered_view_of_rover, 4000.0f);
-            next_mooncoin_spawn = GetTime();
-        }
+#ifdef PROFILE_ZONES
+        if (IsKeyPressed(KEY_F12))
+            write_trace(TRACE_FILE);
+#endif
     }
 
+#ifdef PROFILE_ZONES
+    write_trace(TRACE_FILE);
+#endif
+
+    if (!record_path.empty())
+        save_replay(recording, record_path);
+
     UnloadSound(theme_bgm);
+    sounds.unload();
     CloseAudioDevice();
     CloseWindow();
     return 0;
@@ -0,0 +1,99 @@
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "tests.hpp"
+#include "asteroidstore.hpp"
+#include "ltmath.hpp"
+
+using namespace LookupTableMath;
+
+static constexpr f32 WORLD_EXTENT = 50000.0f;
+
+/**
+ * @brief Check that the orientations turned by AsteroidStore::step stay on the angles they track.
+ */
+TEST_CASE(orientations) {
+    static constexpr usize CHECK_ASTEROIDS = 256;
+    static constexpr usize CHECK_STEPS = 10000;
+    // The angles themselves round by up to half an ulp each step, at a few hundred radians that adds up to about 1e-3
+    // over the steps between two resyncs, while a broken orientation would be off by far more.
+    static constexpr f32 MAX_DRIFT = 2e-3f;
+
+    AsteroidStore store;
+    store.resize(CHECK_ASTEROIDS, test_rng);
+
+    for (usize i = 0; i < CHECK_ASTEROIDS; ++i) {
+        store.get(i).set_angle(test_rng.next_f32() * 2.0f * M_PI);
+        store.get(i).set_angular_velocity(test_rng.next_f32() * 0.1f - 0.05f);
+    }
+
+    store.update_tiers({ -WORLD_EXTENT, -WORLD_EXTENT }, { WORLD_EXTENT, WORLD_EXTENT }, { -WORLD_EXTENT, -WORLD_EXTENT }, { WORLD_EXTENT, WORLD_EXTENT });
+    for (usize i = 0; i < CHECK_STEPS; ++i)
+        store.step(1.0f);
+
+    for (usize i = 0; i < CHECK_ASTEROIDS; ++i) {
+        const Narrowphase::Body body = store.get_body(i);
+        f32 sin_angle, cos_angle;
+        ltsincosf(store.get(i).get_angle(), sin_angle, cos_angle);
+
+        if (std::fabs(body.sin_angle - sin_angle) > MAX_DRIFT or std::fabs(body.cos_angle - cos_angle) > MAX_DRIFT)
+            throw std::runtime_error("orientation check failed: asteroid " + std::to_string(i) + " drifted from its angle.");
+    }
+}
+
+/**
+ * @brief Check that asteroids frozen in the FAR tier come back where stepping them all along would have put them.
+ */
+TEST_CASE(lod) {
+    static constexpr usize CHECK_ASTEROIDS = 256;
+    static constexpr usize CHECK_STEPS = 1000;
+    static constexpr f32 EXTENT = 1000.0f;
+    // Integrating adds a rounding error at every step, while thawing multiplies once, so the two drift a little apart.
+    static constexpr f32 MAX_DRIFT = 0.1f;
+
+    const f32_2 everywhere[2] = { { -2.0f * EXTENT, -2.0f * EXTENT }, { 2.0f * EXTENT, 2.0f * EXTENT } };
+    const f32_2 nowhere[2] = { { 1.0f, 1.0f }, { -1.0f, -1.0f } };
+    AsteroidStore stepped, frozen;
+    Rng shapes = test_rng;
+
+    stepped.resize(CHECK_ASTEROIDS, test_rng);
+    frozen.resize(CHECK_ASTEROIDS, shapes);
+
+    for (usize i = 0; i < CHECK_ASTEROIDS; ++i) {
+        const f32_2 position = { test_rng.next_f32() * EXTENT - EXTENT / 2, test_rng.next_f32() * EXTENT - EXTENT / 2 };
+        const f32_2 velocity = { test_rng.next_f32() * 2.0f - 1.0f, test_rng.next_f32() * 2.0f - 1.0f };
+        const f32 angular_velocity = test_rng.next_f32() * 0.1f - 0.05f;
+
+        for (AsteroidStore* store : { &stepped, &frozen }) {
+            store->get(i).set_position(position);
+            store->get(i).set_velocity(velocity);
+            store->get(i).set_angular_velocity(angular_velocity);
+        }
+    }
+
+    stepped.update_tiers(everywhere[0], everywhere[1], everywhere[0], everywhere[1]);
+    frozen.update_tiers(nowhere[0], nowhere[1], nowhere[0], nowhere[1]);
+
+    for (usize i = 0; i < CHECK_STEPS; ++i) {
+        for (AsteroidStore* store : { &stepped, &frozen }) {
+            store->step(1.0f);
+            store->advance_time(1.0f);
+        }
+    }
+
+    const f32_2 peeked = frozen.get(0).get_position();
+    frozen.update_tiers(everywhere[0], everywhere[1], everywhere[0], everywhere[1]);
+
+    if (peeked.x != frozen.get(0).get_position().x or peeked.y != frozen.get(0).get_position().y)
+        throw std::runtime_error("lod check failed: a frozen asteroid did not report where it thawed.");
+
+    for (usize i = 0; i < CHECK_ASTEROIDS; ++i) {
+        const f32_2 a = stepped.get(i).get_position();
+        const f32_2 b = frozen.get(i).get_position();
+        const f32 angle_drift = std::fabs(stepped.get(i).get_angle() - frozen.get(i).get_angle());
+
+        if (frozen.get(i).get_tier() != AsteroidStore::NEAR or std::fabs(a.x - b.x) > MAX_DRIFT or std::fabs(a.y - b.y) > MAX_DRIFT or angle_drift > MAX_DRIFT)
+            throw std::runtime_error("lod check failed: asteroid " + std::to_string(i) + " thawed away from its stepped copy.");
+    }
+}
@@ -0,0 +1,75 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "tests.hpp"
+#include "chunkstreamer.hpp"
+#include "entity.hpp"
+
+/**
+ * @brief Check that chunks come out the same from the streamer thread and the caller, and that diffs are applied.
+ */
+TEST_CASE(chunks) {
+    static constexpr u64 CHECK_SEED = 7;
+    static constexpr usize CHECK_ASTEROIDS = 64;
+    static constexpr ChunkCoord CHECK_CHUNK = { -3, 5 };
+
+    const std::vector<ChunkAsteroid> expected = ChunkStreamer::generate(CHECK_SEED, CHECK_CHUNK, CHECK_ASTEROIDS);
+    const f32_2 origin = CHECK_CHUNK.origin();
+    ChunkStreamer streamer(CHECK_SEED, CHECK_ASTEROIDS, 1);
+    std::vector<ChunkAsteroid> taken;
+
+    streamer.prefetch(CHECK_CHUNK);
+    if (streamer.take(CHECK_CHUNK, taken) != expected.size() or taken.size() != expected.size())
+        throw std::runtime_error("chunk check failed: the streamed chunk has a different amount of asteroids.");
+
+    for (usize i = 0; i < expected.size(); ++i)
+        if (taken[i].id != expected[i].id or taken[i].shape_id != expected[i].shape_id or taken[i].position.x != origin.x + expected[i].position.x)
+            throw std::runtime_error("chunk check failed: asteroid " + std::to_string(i) + " differs from the generated one.");
+
+    ChunkDiff diff;
+    for (u16 id = 0; id < 2; ++id)
+        diff.remove(id);
+    diff.changed.push_back(expected[1]);
+    streamer.store_diff(CHECK_CHUNK, std::move(diff));
+
+    if (streamer.take(CHECK_CHUNK, taken) != expected.size() - 2 or taken.back().id != 1 or taken.front().id == 0)
+        throw std::runtime_error("chunk check failed: the diff was not applied.");
+
+    // A changed asteroid left on top of a generated one keeps its place, and the generated one is left out.
+    ChunkAsteroid stray = expected[2];
+    stray.id = ChunkAsteroid::NO_ID;
+    streamer.add_changed(CHECK_CHUNK, stray);
+
+    const usize untouched = streamer.take(CHECK_CHUNK, taken);
+    if (untouched != expected.size() - 3 or taken.size() != expected.size() - 1)
+        throw std::runtime_error("chunk check failed: a generated asteroid under a changed one was not left out.");
+
+    for (usize i = 0; i < untouched; ++i)
+        if (taken[i].id == 2)
+            throw std::runtime_error("chunk check failed: a generated asteroid overlaps a changed one.");
+
+    // Any square of loaded chunks shares out the whole capacity, also when there are fewer asteroids than chunks.
+    for (usize capacity : { static_cast<usize>(10), static_cast<usize>(864) }) {
+        const ChunkStreamer shared(CHECK_SEED, capacity, 5);
+
+        for (i32 corner = -7; corner <= 7; corner += 3) {
+            usize total = 0;
+            for (i32 y = corner; y < corner + 5; ++y)
+                for (i32 x = -corner; x < -corner + 5; ++x)
+                    total += shared.get_asteroid_count({ x, y });
+
+            if (total != capacity)
+                throw std::runtime_error("chunk check failed: chunks share out " + std::to_string(total) + " asteroids of " + std::to_string(capacity) + ".");
+        }
+    }
+
+    // A crowded chunk, where many placements are rejected, still has no overlaps.
+    const std::vector<ChunkAsteroid> crowded = ChunkStreamer::generate(CHECK_SEED, CHECK_CHUNK, 4000);
+    const ShapeLibrary& library = ShapeLibrary::shared();
+
+    for (usize i = 0; i < crowded.size(); ++i)
+        for (usize j = i + 1; j < crowded.size(); ++j)
+            if (Entity::is_circle_overlap(crowded[i].position, library.get_radius(crowded[i].shape_id), crowded[j].position, library.get_radius(crowded[j].shape_id)))
+                throw std::runtime_error("chunk check failed: asteroids " + std::to_string(i) + " and " + std::to_string(j) + " overlap.");
+}
@@ -0,0 +1,46 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "tests.hpp"
+#include "entitypool.hpp"
+
+/**
+ * @brief Check that handles follow their entities as the pool compacts, and go stale once released or recycled.
+ */
+TEST_CASE(pool) {
+    static constexpr usize CHECK_CAPACITY = 1024;
+
+    EntityPool pool(CHECK_CAPACITY, EntityPool::REFUSE);
+    std::vector<EntityHandle> handles(CHECK_CAPACITY);
+    std::vector<u32> payloads(CHECK_CAPACITY); // Moved like the storage of an owner, tells which entity is where.
+    usize index;
+
+    for (u32 i = 0; i < CHECK_CAPACITY; ++i) {
+        handles[i] = pool.allocate(index);
+        payloads[index] = i;
+    }
+
+    if (pool.allocate(index) != EntityHandle{ U32MAX, 0 } or index != EntityPool::NO_INDEX)
+        throw std::runtime_error("pool check failed: a full pool did not refuse.");
+
+    for (u32 i = 0; i < CHECK_CAPACITY; i += 3) {
+        const usize freed = pool.release(handles[i]);
+        payloads[freed] = payloads[pool.size()];
+    }
+
+    for (u32 i = 0; i < CHECK_CAPACITY; ++i) {
+        const bool released = i % 3 == 0;
+        if (pool.is_valid(handles[i]) == released or (!released and payloads[pool.index_of(handles[i])] != i))
+            throw std::runtime_error("pool check failed: handle " + std::to_string(i) + " lost its entity.");
+    }
+
+    pool.set_policy(EntityPool::RECYCLE_OLDEST);
+    while (!pool.is_full())
+        pool.allocate(index);
+
+    // The oldest live entity is the first one that was never released.
+    const EntityHandle recycled = pool.allocate(index);
+    if (pool.is_valid(handles[1]) or payloads[index] != 1 or pool.index_of(recycled) != index)
+        throw std::runtime_error("pool check failed: recycling did not take the oldest entity.");
+}
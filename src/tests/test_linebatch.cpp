@@ -0,0 +1,32 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "tests.hpp"
+#include "asteroid.hpp"
+#include "linebatch.hpp"
+
+/**
+ * @brief Check that a batch of outlines turns every edge into one line, as a pair of vertexes.
+ */
+TEST_CASE(line_batch) {
+    static constexpr usize CHECK_ASTEROIDS = 256;
+
+    std::vector<Asteroid> asteroids;
+    f32_2 outline[EntityShape::MAX_VERTEXES + 1];
+    LineBatch batch;
+    usize expected = 0;
+
+    for (usize i = 0; i < CHECK_ASTEROIDS; ++i) {
+        asteroids.push_back(Asteroid(test_rng));
+        asteroids.back().set_position({ test_rng.next_f32() * 50000.0f - 25000.0f, test_rng.next_f32() * 50000.0f - 25000.0f });
+        asteroids.back().step(1.0f);
+        expected += 2 * (asteroids.back().get_entity_vtx_count() - 1);
+    }
+
+    for (const Asteroid& asteroid : asteroids)
+        batch.add_strip(asteroid.get_interpolated_vtx_array(1.0f, outline), asteroid.get_entity_vtx_count(), WHITE);
+
+    if (batch.get_layer_count() != 1 or batch.get_vertex_count() != expected)
+        throw std::runtime_error("line batch check failed: " + std::to_string(batch.get_vertex_count()) + " vertexes, expected " + std::to_string(expected) + ".");
+}
@@ -0,0 +1,32 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "tests.hpp"
+#include "ltmath.hpp"
+
+using namespace LookupTableMath;
+
+/**
+ * @brief Check the lookup table functions against the documented LookupTableMath::MAX_ERROR.
+ */
+TEST_CASE(trig) {
+    static constexpr usize CHECK_ANGLES = 1 << 20;
+    static constexpr f32 CHECK_RANGE = 1000.0f;
+
+    f64 max_error = 0.0;
+
+    for (usize i = 0; i < CHECK_ANGLES; ++i) {
+        const f32 rad = (static_cast<f32>(i) / CHECK_ANGLES * 2.0f - 1.0f) * CHECK_RANGE;
+        max_error = std::max(max_error, std::fabs(ltsinf(rad) - std::sin(static_cast<f64>(rad))));
+        max_error = std::max(max_error, std::fabs(ltcosf(rad) - std::cos(static_cast<f64>(rad))));
+
+        const f32 rad_q = static_cast<f32>(i) / CHECK_ANGLES * 2.0f * M_PI;
+        max_error = std::max(max_error, std::fabs(ltsinf_q(rad_q) - std::sin(static_cast<f64>(rad_q))));
+        max_error = std::max(max_error, std::fabs(ltcosf_q(rad_q) - std::cos(static_cast<f64>(rad_q))));
+    }
+
+    if (max_error > MAX_ERROR)
+        throw std::runtime_error("trig check failed: error " + std::to_string(max_error) + " is above MAX_ERROR.");
+}
@@ -0,0 +1,48 @@
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+#include "tests.hpp"
+#include "asteroid.hpp"
+
+static bool is_edge_collision(const Asteroid& a, const Asteroid& b) {
+    return Entity::is_outline_intersection(
+        a.get_outline_bounding_box(), a.get_entity_vtx_array(), a.get_entity_vtx_count() - 1,
+        b.get_outline_bounding_box(), b.get_entity_vtx_array(), b.get_entity_vtx_count() - 1
+    );
+}
+
+/**
+ * @brief Check the separating axis narrowphase against the edge test on random placements.
+ *
+ * Crossing outlines must always collide. The narrowphase may find more collisions than the edge test, but only
+ * when one outline sits inside the other, which the edge test misses.
+ */
+TEST_CASE(narrowphase) {
+    static constexpr usize CHECK_PAIRS = 20000;
+
+    Asteroid a;
+    Asteroid b;
+    usize contained = 0;
+
+    for (usize i = 0; i < CHECK_PAIRS; ++i) {
+        a = Asteroid();
+        b = Asteroid();
+        a.set_angle(test_rng.next_f32() * 8.0f);
+        b.set_angle(test_rng.next_f32() * 8.0f);
+        b.set_position({ test_rng.next_f32() * 200.0f - 100.0f, test_rng.next_f32() * 200.0f - 100.0f });
+
+        Narrowphase::Contact contact;
+        const bool edges = is_edge_collision(a, b);
+        const bool sat = a.is_collision(b, &contact);
+
+        if (edges and !sat)
+            throw std::runtime_error("narrowphase check failed: crossing outlines were not found colliding.");
+        if (sat and (contact.depth <= 0.0f or std::fabs(contact.normal.x * contact.normal.x + contact.normal.y * contact.normal.y - 1.0f) > 1e-3f))
+            throw std::runtime_error("narrowphase check failed: contact is not a unit normal with a positive depth.");
+
+        contained += sat and !edges;
+    }
+
+    std::cerr << "narrowphase check: " << contained << " of " << CHECK_PAIRS << " pairs collide only by containment\n";
+}
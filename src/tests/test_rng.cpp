@@ -0,0 +1,31 @@
+#include <stdexcept>
+
+#include "tests.hpp"
+
+/**
+ * @brief Check that streams replay the same values, that separate streams differ, and that ranges are respected.
+ */
+TEST_CASE(rng) {
+    static constexpr usize CHECK_DRAWS = 1 << 16;
+
+    Rng a(CHECK_DRAWS, Rng::stream(Rng::WORLD_STREAM, 0));
+    Rng b(CHECK_DRAWS, Rng::stream(Rng::WORLD_STREAM, 0));
+    Rng other(CHECK_DRAWS, Rng::stream(Rng::WORLD_STREAM, 1));
+    Rng ranged(CHECK_DRAWS, Rng::BENCH_STREAM);
+    usize same_as_other = 0;
+
+    for (usize i = 0; i < CHECK_DRAWS; ++i) {
+        const u32 value = a.next_u32();
+        if (value != b.next_u32())
+            throw std::runtime_error("rng check failed: a stream did not replay its values.");
+        same_as_other += value == other.next_u32();
+
+        const f32 f = ranged.next_f32();
+        const i32 n = ranged.next_i32(-3, 3);
+        if (f < 0.0f or f >= 1.0f or n < -3 or n > 3)
+            throw std::runtime_error("rng check failed: a value is out of its range.");
+    }
+
+    if (same_as_other > 4)
+        throw std::runtime_error("rng check failed: two streams of a seed are correlated.");
+}
@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "tests.hpp"
+#include "asteroid.hpp"
+#include "vtxkernel.hpp"
+
+/**
+ * @brief Batch of random asteroid outlines to transform, with one output buffer per kernel implementation.
+ */
+struct KernelBatch {
+    std::vector<f32_2> shape_vertexes;
+    std::vector<VertexKernel::Job> jobs;
+    std::vector<f32_2> rel_vertexes;
+    std::vector<f32_2> bounding_boxes;
+
+    KernelBatch(usize count) {
+        std::vector<usize> offsets(count);
+
+        for (usize i = 0; i < count; ++i) {
+            const AsteroidShape shape(test_rng.next_i32(6, AsteroidShape::MAX_VERTEXES), test_rng.next_f32() * 50.0f + 5.0f, test_rng);
+            offsets[i] = shape_vertexes.size();
+            shape_vertexes.insert(shape_vertexes.end(), shape.data().vertexes, shape.data().vertexes + shape.data().vtx_count);
+        }
+
+        rel_vertexes.resize(shape_vertexes.size() + count);
+        bounding_boxes.resize(2 * count);
+
+        for (usize i = 0; i < count; ++i) {
+            const usize vtx_count = (i + 1 < count ? offsets[i + 1] : shape_vertexes.size()) - offsets[i];
+            const f32 angle = test_rng.next_f32() * 2.0f * M_PI;
+            const VertexKernel::Job job = {
+                &shape_vertexes[offsets[i]], vtx_count,
+                { test_rng.next_f32() * 50000.0f - 25000.0f, test_rng.next_f32() * 50000.0f - 25000.0f },
+                std::sin(angle), std::cos(angle),
+                &rel_vertexes[offsets[i] + i], &bounding_boxes[2 * i]
+            };
+            jobs.push_back(job);
+        }
+    }
+};
+
+/**
+ * @brief Differential check of every supported kernel implementation against the scalar one.
+ *
+ * Outlines must be bit identical, bounding boxes must compare equal (the reduction order can change the sign of a
+ * zero coordinate, nothing else).
+ */
+TEST_CASE(kernels) {
+    static constexpr usize CHECK_OUTLINES = 1000;
+
+    KernelBatch batch(CHECK_OUTLINES);
+
+    VertexKernel::transform(batch.jobs.data(), batch.jobs.size(), VertexKernel::SCALAR);
+    const std::vector<f32_2> expected_vertexes = batch.rel_vertexes;
+    const std::vector<f32_2> expected_boxes = batch.bounding_boxes;
+
+    for (int isa = VertexKernel::SSE2; isa <= VertexKernel::AVX2; ++isa) {
+        if (!VertexKernel::is_supported(static_cast<VertexKernel::Isa>(isa)))
+            continue;
+
+        std::fill(batch.rel_vertexes.begin(), batch.rel_vertexes.end(), VECTOR2ZERO);
+        std::fill(batch.bounding_boxes.begin(), batch.bounding_boxes.end(), VECTOR2ZERO);
+        VertexKernel::transform(batch.jobs.data(), batch.jobs.size(), static_cast<VertexKernel::Isa>(isa));
+
+        const std::string name = VertexKernel::isa_name(static_cast<VertexKernel::Isa>(isa));
+
+        if (std::memcmp(expected_vertexes.data(), batch.rel_vertexes.data(), expected_vertexes.size() * sizeof(f32_2)) != 0)
+            throw std::runtime_error("kernel check failed: " + name + " outlines differ from scalar.");
+
+        for (usize i = 0; i < expected_boxes.size(); ++i)
+            if (expected_boxes[i].x != batch.bounding_boxes[i].x or expected_boxes[i].y != batch.bounding_boxes[i].y)
+                throw std::runtime_error("kernel check failed: " + name + " bounding boxes differ from scalar.");
+    }
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tests.hpp"
+#include "world.hpp"
+
+static constexpr f32 VIEWPORT_W = 1680.0f;
+static constexpr f32 VIEWPORT_H = 960.0f;
+static constexpr f32 WORLD_EXTENT = 50000.0f;
+
+/**
+ * @brief Check that freshly built worlds place their whole capacity, and have no overlapping asteroids, also across
+ * the borders of their chunks.
+ */
+TEST_CASE(world_placement) {
+    static constexpr u64 CHECK_SEEDS = 20;
+    static constexpr usize LARGE_CAPACITY = 100000;
+
+    const ShapeLibrary& library = ShapeLibrary::shared();
+
+    // Far more than the default loaded chunks can hold.
+    const World large({ 0.0f, 0.0f }, { VIEWPORT_W, VIEWPORT_H }, nullptr, nullptr, LARGE_CAPACITY);
+    if (large.get_asteroid_count() != LARGE_CAPACITY)
+        throw std::runtime_error("world placement check failed: placed " + std::to_string(large.get_asteroid_count()) + " of " + std::to_string(LARGE_CAPACITY) + " asteroids.");
+
+    for (u64 seed = 1; seed <= CHECK_SEEDS; ++seed) {
+        World world({ 0.0f, 0.0f }, { VIEWPORT_W, VIEWPORT_H }, nullptr, nullptr, World::DEFAULT_ASTEROID_CAPACITY, seed);
+
+        if (world.get_asteroid_count() != World::DEFAULT_ASTEROID_CAPACITY)
+            throw std::runtime_error("world placement check failed: seed " + std::to_string(seed) + " placed " + std::to_string(world.get_asteroid_count()) + " asteroids.");
+
+        for (usize i = 0; i < world.get_asteroid_count(); ++i) {
+            const AsteroidStore::Ref a = world.get_asteroid(i);
+
+            for (usize j = i + 1; j < world.get_asteroid_count(); ++j) {
+                const AsteroidStore::Ref b = world.get_asteroid(j);
+
+                if (Entity::is_circle_overlap(a.get_position(), library.get_radius(a.get_shape_id()), b.get_position(), library.get_radius(b.get_shape_id())))
+                    throw std::runtime_error("world placement check failed: seed " + std::to_string(seed) + " starts with asteroids " + std::to_string(i) + " and " + std::to_string(j) + " overlapping.");
+            }
+        }
+    }
+}
+
+/**
+ * @brief Check that asteroids drifting out of their chunk are kept by the chunk they drift into.
+ */
+TEST_CASE(chunk_drift) {
+    static constexpr u64 CHECK_SEED = 7;
+
+    const auto view_at = [](ChunkCoord chunk) -> f32_2 {
+        const f32_2 origin = chunk.origin();
+        return { origin.x + ChunkCoord::CHUNK_SIZE / 2 - VIEWPORT_W / 2, origin.y + ChunkCoord::CHUNK_SIZE / 2 - VIEWPORT_H / 2 };
+    };
+
+    World world(view_at({ 0, 0 }), { VIEWPORT_W, VIEWPORT_H }, nullptr, nullptr, World::DEFAULT_ASTEROID_CAPACITY, CHECK_SEED);
+
+    // Two untouched asteroids of chunk (-2, 0), which is evicted once the view moves to (1, 0): one moved into the
+    // chunk that stays at the center, the other far past the loaded chunks.
+    usize picked[2];
+    usize found = 0;
+    for (usize i = 0; found < 2 and i < world.get_asteroid_count(); ++i)
+        if (ChunkCoord::of(world.get_asteroid(i).get_position()) == ChunkCoord{ -2, 0 })
+            picked[found++] = i;
+
+    if (found < 2)
+        throw std::runtime_error("chunk drift check failed: chunk (-2, 0) has too few asteroids.");
+
+    const EntityHandle kept = world.get_asteroid_handle(picked[0]);
+    const ChunkCoord far_chunk = { 10, 0 };
+    const f32_2 far_position = { far_chunk.origin().x + 1000.0f, 1000.0f };
+    const f32_2 far_velocity = world.get_asteroid(picked[1]).get_velocity();
+    const ShapeId far_shape = world.get_asteroid(picked[1]).get_shape_id();
+    world.get_asteroid(picked[0]).set_position({ 1000.0f, 1000.0f });
+    world.get_asteroid(picked[1]).set_position(far_position);
+
+    world.set_position(view_at({ 1, 0 }));
+    world.step(1.0f);
+
+    if (world.get_asteroid_index(kept) == EntityPool::NO_INDEX)
+        throw std::runtime_error("chunk drift check failed: an asteroid drifted into a loaded chunk was evicted.");
+
+    // Stored by the far chunk when its old chunk was evicted, where it stays until loaded, and then moved by a step.
+    world.set_position(view_at(far_chunk));
+    world.step(1.0f);
+
+    const f32_2 expected = { far_position.x + far_velocity.x, far_position.y + far_velocity.y };
+    bool restored = false;
+    for (usize i = 0; !restored and i < world.get_asteroid_count(); ++i) {
+        const f32_2 pos = world.get_asteroid(i).get_position();
+        restored = world.get_asteroid(i).get_shape_id() == far_shape and std::abs(pos.x - expected.x) < 1.0f and std::abs(pos.y - expected.y) < 1.0f;
+    }
+
+    if (!restored)
+        throw std::runtime_error("chunk drift check failed: an asteroid drifted past the loaded chunks was lost.");
+}
+
+/**
+ * @brief Check that stepping a world gives the same state on one thread and on many.
+ */
+TEST_CASE(world_threads) {
+    static constexpr u32 CHECK_SEED = 7;
+    static constexpr usize CHECK_STEPS = 20;
+
+    const usize max_threads = std::max<usize>(4, std::thread::hardware_concurrency());
+    std::vector<f32_2> expected;
+
+    for (usize threads : { static_cast<usize>(1), max_threads }) {
+        World world({ -WORLD_EXTENT / 2, -WORLD_EXTENT / 2 }, { WORLD_EXTENT, WORLD_EXTENT }, nullptr, nullptr, World::DEFAULT_ASTEROID_CAPACITY, CHECK_SEED);
+        world.set_thread_count(threads);
+
+        for (usize i = 0; i < CHECK_STEPS; ++i)
+            world.step(1.0f);
+
+        std::vector<f32_2> positions(world.get_asteroid_count());
+        for (usize i = 0; i < positions.size(); ++i)
+            positions[i] = world.get_asteroid(i).get_position();
+
+        if (expected.empty())
+            expected = positions;
+        else if (expected.size() != positions.size() or std::memcmp(expected.data(), positions.data(), expected.size() * sizeof(f32_2)) != 0)
+            throw std::runtime_error("world thread check failed: " + std::to_string(threads) + " threads diverge from a single thread.");
+    }
+}
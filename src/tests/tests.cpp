@@ -0,0 +1,58 @@
+#include <cstring>
+#include <exception>
+#include <iostream>
+
+#include "tests.hpp"
+#include "shapelibrary.hpp"
+
+/**
+ * @brief Correctness test runner.
+ *
+ * Runs the tests named on the command line, or every test without arguments, and exits with a failure if any of
+ * them throws. Each test starts from the same seed, so it draws the same inputs alone as in a full run.
+ */
+
+Rng test_rng;
+
+static bool is_selected(const char* name, int argc, char** argv) {
+    for (int i = 1; i < argc; ++i)
+        if (std::strcmp(argv[i], name) == 0)
+            return true;
+
+    return argc == 1;
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        bool known = false;
+        for (const Tests::Case& test : Tests::all())
+            known = known or std::strcmp(argv[i], test.name) == 0;
+
+        if (!known) {
+            std::cerr << "Usage: " << argv[0] << " [TEST...]\n  Unknown test \"" << argv[i] << "\", the tests are:\n";
+            for (const Tests::Case& test : Tests::all())
+                std::cerr << "    " << test.name << "\n";
+            return 1;
+        }
+    }
+
+    ShapeLibrary::set_shared_seed(Rng::DEFAULT_SEED);
+    usize failed = 0;
+
+    for (const Tests::Case& test : Tests::all()) {
+        if (!is_selected(test.name, argc, argv))
+            continue;
+
+        test_rng = Rng(Rng::DEFAULT_SEED, Rng::TEST_STREAM);
+
+        try {
+            test.run();
+            std::cerr << test.name << ": ok\n";
+        } catch (const std::exception& e) {
+            std::cerr << test.name << ": " << e.what() << "\n";
+            ++failed;
+        }
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,39 @@
+#ifndef TESTS_HPP_
+#define TESTS_HPP_
+
+#include <vector>
+
+#include "typedef.hpp"
+#include "rng.hpp"
+
+/**
+ * @brief Registry of the correctness tests, run by the tests executable.
+ *
+ * A test is a function that throws std::runtime_error when it fails. TEST_CASE defines one and registers it under
+ * its name, so each subsystem keeps its tests in its own source, and CTest runs each of them on its own by name.
+ */
+class Tests {
+public:
+    struct Case {
+        const char* name;
+        void (*run)();
+    };
+
+    struct Registrar {
+        Registrar(const char* name, void (*run)()) { all().push_back({ name, run }); }
+    };
+
+    static std::vector<Case>& all() {
+        static std::vector<Case> cases;
+        return cases;
+    }
+};
+
+extern Rng test_rng; // Reseeded before each test, draws the random inputs of the tests.
+
+#define TEST_CASE(name)                                          \
+    static void name();                                          \
+    static const Tests::Registrar name##_registrar(#name, name); \
+    static void name()
+
+#endif
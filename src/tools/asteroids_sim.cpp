@@ -0,0 +1,224 @@
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <raylib.h>
+
+#include "typedef.hpp"
+#include "world.hpp"
+#include "smoothcam.hpp"
+#include "gamerules.hpp"
+#include "replay.hpp"
+#include "profiler.hpp"
+
+/**
+ * @brief Headless simulation runner.
+ *
+ * Steps the World for a set amount of ticks without opening a window or an audio device, then prints the
+ * throughput and a checksum of the final state, so that runs can be profiled and compared between revisions.
+ *
+ * The input script is a comma separated list of KEYS:TICKS segments, looped until the run ends. KEYS is any
+ * combination of W, A and D (or empty to release everything), for example "W:120,WA:30,:60,WD:45".
+ *
+ * A replay recorded by the game (or with --record) replaces the script, the seed, the world settings and the amount
+ * of ticks with its own, so it ends on the same state the recorded session did.
+ */
+
+struct InputSegment {
+    RoverInput input;
+    usize ticks;
+};
+
+static constexpr f32 VIEWPORT_W = 1680.0f;
+static constexpr f32 VIEWPORT_H = 960.0f;
+
+static std::vector<InputSegment> parse_input_script(const std::string& script) {
+    std::vector<InputSegment> segments;
+    usize start = 0;
+
+    while (start <= script.size()) {
+        usize end = script.find(',', start);
+        if (end == std::string::npos)
+            end = script.size();
+
+        const std::string segment = script.substr(start, end - start);
+        const usize colon = segment.find(':');
+        if (colon == std::string::npos)
+            throw std::runtime_error("asteroids_sim cannot parse input segment \"" + segment + "\": expected KEYS:TICKS.");
+
+        InputSegment parsed = { { false, false, false }, 0 };
+        for (usize i = 0; i < colon; ++i) {
+            switch (segment[i]) {
+            case 'W': parsed.input.forward = true; break;
+            case 'A': parsed.input.left = true; break;
+            case 'D': parsed.input.right = true; break;
+            default:
+                throw std::runtime_error("asteroids_sim cannot parse input segment \"" + segment + "\": unknown key.");
+            }
+        }
+
+        parsed.ticks = std::stoul(segment.substr(colon + 1));
+        if (parsed.ticks > 0)
+            segments.push_back(parsed);
+
+        start = end + 1;
+    }
+
+    if (segments.empty())
+        throw std::runtime_error("asteroids_sim cannot parse input script: no segment has ticks.");
+
+    return segments;
+}
+
+static u64 hash_f32(u64 hash, f32 value) {
+    u32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (hash ^ bits) * 0x100000001b3ull;
+}
+
+static u64 world_checksum(World& world) {
+    u64 hash = 0xcbf29ce484222325ull;
+
+    for (usize i = 0; i < world.get_asteroid_count(); ++i) {
+        const f32_2 pos = world.get_asteroid(i).get_position();
+        hash = hash_f32(hash_f32(hash, pos.x), pos.y);
+    }
+
+    const f32_2 rover_pos = world.get_rover().get_position();
+    hash = hash_f32(hash_f32(hash, rover_pos.x), rover_pos.y);
+    return hash_f32(hash, world.get_rover().get_health());
+}
+
+static void print_usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [--ticks N] [--seed N] [--asteroids N] [--mooncoins N] [--threads N] [--input SCRIPT] [--record FILE] [--replay FILE] [--trace FILE]\n"
+              << "  --ticks N        Simulation ticks to run (default 3600).\n"
+              << "  --seed N         Random seed (default 1).\n"
+              << "  --asteroids N    Asteroid pool capacity (default " << World::DEFAULT_ASTEROID_CAPACITY << ").\n"
+              << "  --mooncoins N    Mooncoin pool capacity (default " << World::DEFAULT_MOONCOIN_CAPACITY << ").\n"
+              << "  --threads N      Threads stepping the world, 0 for one per hardware thread (default 0).\n"
+              << "  --input SCRIPT   Looped KEYS:TICKS input script (default \"W:120,WA:30,:60,WD:45\").\n"
+              << "  --record FILE    Write the inputs and settings of the run to FILE, as a replay.\n"
+              << "  --replay FILE    Play back a replay, in place of the ticks, seed, pool and input options.\n"
+              << "  --trace FILE     Write the profiling zones of the run to FILE, as a Chrome trace.\n";
+}
+
+int main(int argc, char** argv) {
+    usize ticks = 3600;
+    u32 seed = 1;
+    usize asteroid_count = World::DEFAULT_ASTEROID_CAPACITY;
+    usize mooncoin_count = World::DEFAULT_MOONCOIN_CAPACITY;
+    usize thread_count = 0;
+    std::string script = "W:120,WA:30,:60,WD:45";
+    std::string record_path;
+    std::string replay_path;
+    std::string trace_path;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 1;
+            }
+
+            if (arg == "--ticks")
+                ticks = std::stoul(argv[++i]);
+            else if (arg == "--seed")
+                seed = static_cast<u32>(std::stoul(argv[++i]));
+            else if (arg == "--asteroids")
+                asteroid_count = std::stoul(argv[++i]);
+            else if (arg == "--mooncoins")
+                mooncoin_count = std::stoul(argv[++i]);
+            else if (arg == "--threads")
+                thread_count = std::stoul(argv[++i]);
+            else if (arg == "--input")
+                script = argv[++i];
+            else if (arg == "--record")
+                record_path = argv[++i];
+            else if (arg == "--replay")
+                replay_path = argv[++i];
+            else if (arg == "--trace")
+                trace_path = argv[++i];
+            else {
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+
+        const std::vector<InputSegment> segments = parse_input_script(script);
+
+        Replay::Settings session = { seed, static_cast<u32>(asteroid_count), static_cast<u32>(mooncoin_count), VIEWPORT_W, VIEWPORT_H, 0.0f };
+        std::unique_ptr<Replay> playback;
+        if (!replay_path.empty()) {
+            playback.reset(new Replay(Replay::load(replay_path)));
+            session = playback->get_settings();
+            ticks = playback->get_tick_count();
+        }
+
+        const f32_2 viewport = { session.viewport_w, session.viewport_h };
+        Replay recording(session);
+
+        ShapeLibrary::set_shared_seed(session.seed);
+
+        const std::chrono::steady_clock::time_point init_start = std::chrono::steady_clock::now();
+
+        World world({ 0.0f, 0.0f }, viewport, nullptr, nullptr, session.asteroid_count, session.seed, session.mooncoin_count);
+        world.get_rover().set_position({ viewport.x / 2, viewport.y / 2 });
+        if (session.broadphase_cell_size > 0.0f)
+            world.set_broadphase_cell_size(session.broadphase_cell_size);
+        world.set_thread_count(thread_count);
+        SmoothCamera cam({ 0.0f, 0.0f });
+
+        const std::chrono::steady_clock::time_point step_start = std::chrono::steady_clock::now();
+
+        usize segment = 0;
+        usize segment_tick = 0;
+
+        for (usize tick = 0; tick < ticks; ++tick) {
+            RoverInput input = segments[segment].input;
+            if (playback)
+                input = playback->get_input(tick);
+            else if (++segment_tick == segments[segment].ticks) {
+                segment = (segment + 1) % segments.size();
+                segment_tick = 0;
+            }
+
+            recording.record(input);
+            GameRules::tick(world, cam, input, tick, viewport);
+        }
+
+        const std::chrono::steady_clock::time_point step_end = std::chrono::steady_clock::now();
+
+        const f64 init_s = std::chrono::duration<f64>(step_start - init_start).count();
+        const f64 step_s = std::chrono::duration<f64>(step_end - step_start).count();
+        const usize entity_count = world.get_asteroid_count() + world.get_mooncoin_count() + 1;
+
+        std::cout << "seed              " << session.seed << "\n"
+                  << "ticks             " << ticks << "\n"
+                  << "threads           " << world.get_thread_count() << "\n"
+                  << "entities          " << entity_count << "\n"
+                  << "init_s            " << init_s << "\n"
+                  << "step_s            " << step_s << "\n"
+                  << "steps_per_s       " << (step_s > 0.0 ? ticks / step_s : 0.0) << "\n"
+                  << "ns_per_entity     " << (ticks > 0 ? step_s * 1e9 / (static_cast<f64>(ticks) * entity_count) : 0.0) << "\n"
+                  << "loaded_chunks     " << world.get_loaded_chunk_count() << "\n"
+                  << "chunk_diffs       " << world.get_chunk_diff_count() << "\n"
+                  << "collected         " << world.get_collected_mooncoins() << "\n"
+                  << "rover_health      " << world.get_rover().get_health() << "\n"
+                  << "checksum          " << std::hex << world_checksum(world) << std::dec << "\n";
+
+        if (!record_path.empty())
+            recording.save(record_path);
+
+        if (!trace_path.empty())
+            std::cout << "trace_zones       " << Profiler::write_chrome_trace(trace_path) << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
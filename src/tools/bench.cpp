@@ -0,0 +1,557 @@
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <raylib.h>
+
+#include "typedef.hpp"
+#include "ltmath.hpp"
+#include "rng.hpp"
+#include "asteroid.hpp"
+#include "world.hpp"
+#include "chunkstreamer.hpp"
+#include "vtxkernel.hpp"
+#include "linebatch.hpp"
+#include "profiler.hpp"
+
+/**
+ * @brief Benchmark suite for the simulation hot paths.
+ *
+ * Each benchmark runs its body until MIN_BENCH_TIME has passed (at least once), and reports the time per
+ * iteration and per entity. The results are written as JSON, to stdout or to the --out file, so that they can be
+ * compared between revisions. Correctness is checked by the tests executable instead, so any subset of the
+ * benchmarks can be timed.
+ */
+
+using namespace LookupTableMath;
+
+static constexpr f64 MIN_BENCH_TIME = 0.25;
+static constexpr f32 VIEWPORT_W = 1680.0f;
+static constexpr f32 VIEWPORT_H = 960.0f;
+static constexpr f32 WORLD_EXTENT = 50000.0f;
+
+static Rng bench_rng; // Reseeded from --seed, draws the random inputs of the benchmarks.
+
+/**
+ * @brief Asteroid exposing the protected members the benchmarks call directly.
+ */
+class BenchAsteroid : public Asteroid {
+public:
+    BenchAsteroid() : Asteroid(bench_rng) {}
+    explicit BenchAsteroid(ShapeId shape_id) : Asteroid(shape_id) {}
+
+    using Entity::update_bounding_box;
+};
+
+struct BenchResult {
+    std::string name;
+    std::string variant;
+    usize entities;
+    usize iterations;
+    f64 ns_per_iter;
+};
+
+class BenchRunner {
+private:
+    std::vector<BenchResult> results;
+    std::string filter;
+
+public:
+    volatile f32 sink = 0.0f;
+
+    BenchRunner(const std::string& filter) : filter(filter) {}
+
+    bool enabled(const std::string& name) const { return filter.empty() or name.find(filter) != std::string::npos; }
+
+    void run(const std::string& name, const std::string& variant, usize entities, const std::function<void()>& body) {
+        if (!enabled(name))
+            return;
+
+        usize iterations = 0;
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        f64 elapsed = 0.0;
+
+        do {
+            body();
+            ++iterations;
+            elapsed = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+        } while (elapsed < MIN_BENCH_TIME);
+
+        const BenchResult result = { name, variant, entities, iterations, elapsed * 1e9 / iterations };
+        results.push_back(result);
+
+        std::cerr << name << (variant.empty() ? "" : "/" + variant) << " [" << entities << "]: "
+                  << result.ns_per_iter << " ns/iter, " << result.ns_per_iter / (entities ? entities : 1) << " ns/entity\n";
+    }
+
+    std::string to_json() const {
+        std::ostringstream out;
+        out.precision(6);
+        out << std::fixed;
+
+        out << "{\n  \"benchmarks\": [\n";
+        for (usize i = 0; i < results.size(); ++i) {
+            const BenchResult& r = results[i];
+            out << "    { \"name\": \"" << r.name << "\", \"variant\": \"" << r.variant << "\", \"entities\": " << r.entities
+                << ", \"iterations\": " << r.iterations << ", \"ns_per_iter\": " << r.ns_per_iter
+                << ", \"ns_per_entity\": " << r.ns_per_iter / (r.entities ? r.entities : 1) << " }"
+                << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+
+        return out.str();
+    }
+};
+
+static std::vector<usize> parse_counts(const std::string& list) {
+    std::vector<usize> counts;
+    std::istringstream in(list);
+    std::string item;
+
+    while (std::getline(in, item, ','))
+        if (!item.empty())
+            counts.push_back(std::stoul(item));
+
+    return counts;
+}
+
+static std::unique_ptr<BenchAsteroid[]> make_asteroids(usize count) {
+    std::unique_ptr<BenchAsteroid[]> asteroids(new BenchAsteroid[count]);
+
+    for (usize i = 0; i < count; ++i) {
+        asteroids[i].set_position({ bench_rng.next_f32() * 50000.0f - 25000.0f, bench_rng.next_f32() * 50000.0f - 25000.0f });
+        asteroids[i].set_velocity({ bench_rng.next_f32() * 2.0f - 1.0f, bench_rng.next_f32() * 2.0f - 1.0f });
+        asteroids[i].set_angular_velocity(bench_rng.next_f32() * 0.1f - 0.05f);
+        asteroids[i].step(1.0f);
+    }
+
+    return asteroids;
+}
+
+static void bench_entity(BenchRunner& runner, usize count) {
+    std::unique_ptr<BenchAsteroid[]> asteroids = make_asteroids(count);
+
+    runner.run("entity_step", "", count, [&] {
+        for (usize i = 0; i < count; ++i)
+            asteroids[i].step(1.0f);
+    });
+
+    runner.run("entity_update_bounding_box", "", count, [&] {
+        for (usize i = 0; i < count; ++i)
+            asteroids[i].update_bounding_box();
+    });
+}
+
+/**
+ * @brief Batch of random asteroid outlines to transform, with one output buffer per kernel implementation.
+ */
+struct KernelBatch {
+    std::vector<f32_2> shape_vertexes;
+    std::vector<VertexKernel::Job> jobs;
+    std::vector<f32_2> rel_vertexes;
+    std::vector<f32_2> bounding_boxes;
+
+    KernelBatch(usize count) {
+        std::vector<usize> offsets(count);
+
+        for (usize i = 0; i < count; ++i) {
+            const AsteroidShape shape(bench_rng.next_i32(6, AsteroidShape::MAX_VERTEXES), bench_rng.next_f32() * 50.0f + 5.0f, bench_rng);
+            offsets[i] = shape_vertexes.size();
+            shape_vertexes.insert(shape_vertexes.end(), shape.data().vertexes, shape.data().vertexes + shape.data().vtx_count);
+        }
+
+        rel_vertexes.resize(shape_vertexes.size() + count);
+        bounding_boxes.resize(2 * count);
+
+        for (usize i = 0; i < count; ++i) {
+            const usize vtx_count = (i + 1 < count ? offsets[i + 1] : shape_vertexes.size()) - offsets[i];
+            const f32 angle = bench_rng.next_f32() * 2.0f * M_PI;
+            const VertexKernel::Job job = {
+                &shape_vertexes[offsets[i]], vtx_count,
+                { bench_rng.next_f32() * 50000.0f - 25000.0f, bench_rng.next_f32() * 50000.0f - 25000.0f },
+                std::sin(angle), std::cos(angle),
+                &rel_vertexes[offsets[i] + i], &bounding_boxes[2 * i]
+            };
+            jobs.push_back(job);
+        }
+    }
+};
+
+static void bench_kernel(BenchRunner& runner, usize count) {
+    KernelBatch batch(count);
+
+    for (int isa = VertexKernel::SCALAR; isa <= VertexKernel::AVX2; ++isa) {
+        if (!VertexKernel::is_supported(static_cast<VertexKernel::Isa>(isa)))
+            continue;
+
+        runner.run("vertex_kernel", VertexKernel::isa_name(static_cast<VertexKernel::Isa>(isa)), count, [&] {
+            VertexKernel::transform(batch.jobs.data(), batch.jobs.size(), static_cast<VertexKernel::Isa>(isa));
+        });
+    }
+}
+
+static void place(BenchAsteroid& asteroid, f32_2 position) {
+    // Build the outline right away, so that only the collision test itself is measured.
+    asteroid.set_position(position);
+    asteroid.get_entity_vtx_array();
+}
+
+static bool is_edge_collision(const BenchAsteroid& a, const BenchAsteroid& b) {
+    return Entity::is_outline_intersection(
+        a.get_outline_bounding_box(), a.get_entity_vtx_array(), a.get_entity_vtx_count() - 1,
+        b.get_outline_bounding_box(), b.get_entity_vtx_array(), b.get_entity_vtx_count() - 1
+    );
+}
+
+static void bench_collision(BenchRunner& runner) {
+    static const usize VTX_PAIRS[][2] = { { 6, 6 }, { 6, 31 }, { 16, 16 }, { 31, 31 } };
+    static constexpr usize PAIR_REPEATS = 1000;
+
+    for (const usize* vtx : VTX_PAIRS) {
+        BenchAsteroid a(ShapeLibrary::shared().add(AsteroidShape(vtx[0], 30.0f, bench_rng)));
+        BenchAsteroid b(ShapeLibrary::shared().add(AsteroidShape(vtx[1], 30.0f, bench_rng)));
+        place(a, { 0.0f, 0.0f });
+
+        const std::string variant = std::to_string(vtx[0]) + "x" + std::to_string(vtx[1]);
+
+        // Touching: the outlines cross, so the test can return early.
+        place(b, { 60.0f, 0.0f });
+        runner.run("entity_is_collision_touching", variant, PAIR_REPEATS, [&] {
+            for (usize i = 0; i < PAIR_REPEATS; ++i)
+                runner.sink = runner.sink + a.is_collision(b);
+        });
+        runner.run("edge_test_touching", variant, PAIR_REPEATS, [&] {
+            for (usize i = 0; i < PAIR_REPEATS; ++i)
+                runner.sink = runner.sink + is_edge_collision(a, b);
+        });
+
+        // Near miss: slide b in until it touches, then back off, so the bounding boxes overlap but every edge
+        // pair has to be tested.
+        f32 offset = 1000.0f;
+        place(b, { offset, 0.0f });
+        while (!a.is_collision(b))
+            place(b, { offset -= 1.0f, 0.0f });
+        place(b, { offset + 1.0f, 0.0f });
+
+        runner.run("entity_is_collision_near_miss", variant, PAIR_REPEATS, [&] {
+            for (usize i = 0; i < PAIR_REPEATS; ++i)
+                runner.sink = runner.sink + a.is_collision(b);
+        });
+        runner.run("edge_test_near_miss", variant, PAIR_REPEATS, [&] {
+            for (usize i = 0; i < PAIR_REPEATS; ++i)
+                runner.sink = runner.sink + is_edge_collision(a, b);
+        });
+
+        // Contact: the same pair overlapping, also computing the contact normal and depth.
+        place(b, { 60.0f, 0.0f });
+        runner.run("entity_is_collision_contact", variant, PAIR_REPEATS, [&] {
+            Narrowphase::Contact contact;
+            for (usize i = 0; i < PAIR_REPEATS; ++i)
+                runner.sink = runner.sink + a.is_collision(b, &contact);
+        });
+    }
+}
+
+/**
+ * @brief The 40 entry, nearest sample lookup that LookupTableMath used before, kept as a baseline.
+ */
+static f32 legacy_ltsinf(f32 rad) {
+    static constexpr int LEGACY_TABLE_SIZE = 40;
+    static std::array<f32, LEGACY_TABLE_SIZE> table;
+    static std::once_flag init_flag;
+
+    std::call_once(init_flag, [] {
+        for (int i = 0; i < LEGACY_TABLE_SIZE; ++i)
+            table[i] = std::sin(i * 2 * M_PI / LEGACY_TABLE_SIZE);
+    });
+
+    rad = std::fmod(rad, 2 * M_PI);
+    int index = static_cast<int>(rad * LEGACY_TABLE_SIZE / (2 * M_PI)) % LEGACY_TABLE_SIZE;
+    if (index < 0)
+        index += LEGACY_TABLE_SIZE;
+    return table[index];
+}
+
+static void bench_trig(BenchRunner& runner, usize count) {
+    std::vector<f32> angles(count);
+    for (usize i = 0; i < count; ++i)
+        angles[i] = bench_rng.next_f32() * 8.0f * M_PI - 4.0f * M_PI;
+
+    runner.run("trig_ltsinf", "", count, [&] {
+        f32 acc = 0.0f;
+        for (usize i = 0; i < count; ++i)
+            acc += ltsinf(angles[i]);
+        runner.sink = acc;
+    });
+
+    runner.run("trig_ltcosf", "", count, [&] {
+        f32 acc = 0.0f;
+        for (usize i = 0; i < count; ++i)
+            acc += ltcosf(angles[i]);
+        runner.sink = acc;
+    });
+
+    runner.run("trig_ltsincosf", "", count, [&] {
+        f32 acc = 0.0f;
+        for (usize i = 0; i < count; ++i) {
+            f32 sin_angle, cos_angle;
+            ltsincosf(angles[i], sin_angle, cos_angle);
+            acc += sin_angle + cos_angle;
+        }
+        runner.sink = acc;
+    });
+
+    runner.run("trig_legacy_ltsinf", "", count, [&] {
+        f32 acc = 0.0f;
+        for (usize i = 0; i < count; ++i)
+            acc += legacy_ltsinf(angles[i]);
+        runner.sink = acc;
+    });
+
+    runner.run("trig_std_sin", "", count, [&] {
+        f32 acc = 0.0f;
+        for (usize i = 0; i < count; ++i)
+            acc += std::sin(angles[i]);
+        runner.sink = acc;
+    });
+
+    runner.run("trig_std_cos", "", count, [&] {
+        f32 acc = 0.0f;
+        for (usize i = 0; i < count; ++i)
+            acc += std::cos(angles[i]);
+        runner.sink = acc;
+    });
+}
+
+/**
+ * @brief The libc rand() draw behind the raylib GetRandomValue that util::randf used before, kept as a baseline
+ * without linking raylib.
+ */
+static f32 legacy_randf() {
+    return static_cast<f32>(std::rand()) / static_cast<f32>(RAND_MAX);
+}
+
+static void bench_rng_draws(BenchRunner& runner, usize count) {
+    runner.run("rng_next_f32", "", count, [&] {
+        f32 acc = 0.0f;
+        for (usize i = 0; i < count; ++i)
+            acc += bench_rng.next_f32();
+        runner.sink = acc;
+    });
+
+    runner.run("rng_legacy_randf", "", count, [&] {
+        f32 acc = 0.0f;
+        for (usize i = 0; i < count; ++i)
+            acc += legacy_randf();
+        runner.sink = acc;
+    });
+}
+
+static void bench_pool(BenchRunner& runner, usize count) {
+    if (!runner.enabled("pool_churn"))
+        return;
+
+    EntityPool pool(count, EntityPool::REFUSE);
+    std::vector<EntityHandle> handles(count);
+    usize index;
+
+    for (usize i = 0; i < count; ++i)
+        handles[i] = pool.allocate(index);
+
+    // Release and allocate back every entity, in a random order so that each release moves another entity.
+    runner.run("pool_churn", "", count, [&] {
+        for (usize i = 0; i < count; ++i) {
+            const usize pick = bench_rng.next_u32() % count;
+            pool.release(handles[pick]);
+            handles[pick] = pool.allocate(index);
+        }
+        runner.sink = static_cast<f32>(index);
+    });
+}
+
+static void bench_chunks(BenchRunner& runner, usize count) {
+    if (!runner.enabled("chunk_generate"))
+        return;
+
+    i32 x = 0;
+    runner.run("chunk_generate", "", count, [&] {
+        runner.sink = static_cast<f32>(ChunkStreamer::generate(1, { x++, 0 }, count).size());
+    });
+}
+
+static void bench_line_batch(BenchRunner& runner, usize count) {
+    if (!runner.enabled("line_batch_build"))
+        return;
+
+    std::unique_ptr<BenchAsteroid[]> asteroids = make_asteroids(count);
+    f32_2 outline[EntityShape::MAX_VERTEXES + 1];
+    LineBatch batch;
+
+    runner.run("line_batch_build", "", count, [&] {
+        batch.clear();
+        for (usize i = 0; i < count; ++i)
+            batch.add_strip(asteroids[i].get_interpolated_vtx_array(1.0f, outline), asteroids[i].get_entity_vtx_count(), WHITE);
+        runner.sink = batch.get_layer(0).vertexes.back().x;
+    });
+}
+
+static void bench_world_construct(BenchRunner& runner, usize count) {
+    if (!runner.enabled("world_construct"))
+        return;
+
+    // Reported per asteroid actually placed, in case the chunks couldn't fit the whole capacity.
+    const usize placed = World({ 0.0f, 0.0f }, { VIEWPORT_W, VIEWPORT_H }, nullptr, nullptr, count).get_asteroid_count();
+    if (placed != count)
+        std::cerr << "world_construct placed " << placed << " of " << count << " asteroids.\n";
+
+    runner.run("world_construct", "", placed, [&] {
+        World world({ 0.0f, 0.0f }, { VIEWPORT_W, VIEWPORT_H }, nullptr, nullptr, count);
+        runner.sink = world.get_asteroid(0).get_position().x;
+    });
+}
+
+static void bench_world(BenchRunner& runner, usize count) {
+    if (runner.enabled("world_step")) {
+        World world({ 0.0f, 0.0f }, { VIEWPORT_W, VIEWPORT_H }, nullptr, nullptr, count);
+
+        // Stepping everything once makes the bounding boxes valid before measuring.
+        world.step(1.0f);
+
+        runner.run("world_step", "", count, [&] {
+            world.step(1.0f);
+        });
+    }
+
+    if (runner.enabled("world_update_visible")) {
+        World world({ 0.0f, 0.0f }, { VIEWPORT_W, VIEWPORT_H }, nullptr, nullptr, count);
+        world.step(1.0f);
+
+        runner.run("world_update_visible", "", count, [&] {
+            world.update_visible({ 0.0f, 0.0f });
+            runner.sink = static_cast<f32>(world.get_visible_asteroids().size());
+        });
+    }
+}
+
+static void bench_world_threads(BenchRunner& runner, usize count) {
+    if (!runner.enabled("world_step_threads"))
+        return;
+
+    // Keep every asteroid in view, so that all of them go through every phase.
+    World world({ -WORLD_EXTENT / 2, -WORLD_EXTENT / 2 }, { WORLD_EXTENT, WORLD_EXTENT }, nullptr, nullptr, count);
+    const usize max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (usize threads = 1;; threads = std::min(2 * threads, max_threads)) {
+        world.set_thread_count(threads);
+        world.step(1.0f);
+
+        runner.run("world_step_threads", std::to_string(threads), count, [&] {
+            world.step(1.0f);
+        });
+
+        if (threads == max_threads)
+            break;
+    }
+}
+
+static void bench_profiler(BenchRunner& runner, usize count) {
+    runner.run("profile_zone", "", count, [&] {
+        for (usize i = 0; i < count; ++i) {
+            const Profiler::Zone zone("bench");
+            runner.sink = runner.sink + 1.0f;
+        }
+    });
+}
+
+static void print_usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [--out FILE] [--filter NAME] [--counts N,N,...] [--max-world N] [--seed N]\n"
+              << "  --out FILE       Write the JSON results to FILE instead of stdout.\n"
+              << "  --filter NAME    Only run benchmarks whose name contains NAME.\n"
+              << "  --counts LIST    Entity counts to scale to (default 864,10000,100000).\n"
+              << "  --max-world N    Skip World step benchmarks above N asteroids (default 10000).\n"
+              << "  --seed N         Random seed (default 1).\n";
+}
+
+int main(int argc, char** argv) {
+    std::string out_path;
+    std::string filter;
+    std::vector<usize> counts = { 864, 10000, 100000 };
+    usize max_world = 10000;
+    u32 seed = 1;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                print_usage(argv[0]);
+                return 1;
+            }
+
+            if (arg == "--out")
+                out_path = argv[++i];
+            else if (arg == "--filter")
+                filter = argv[++i];
+            else if (arg == "--counts")
+                counts = parse_counts(argv[++i]);
+            else if (arg == "--max-world")
+                max_world = std::stoul(argv[++i]);
+            else if (arg == "--seed")
+                seed = static_cast<u32>(std::stoul(argv[++i]));
+            else {
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+
+        ShapeLibrary::set_shared_seed(seed);
+        bench_rng = Rng(seed, Rng::BENCH_STREAM);
+
+        BenchRunner runner(filter);
+
+        bench_collision(runner);
+
+        for (usize count : counts) {
+            bench_entity(runner, count);
+            bench_kernel(runner, count);
+            bench_trig(runner, count);
+            bench_rng_draws(runner, count);
+            bench_pool(runner, count);
+            bench_chunks(runner, count);
+            bench_line_batch(runner, count);
+            bench_profiler(runner, count);
+
+            bench_world_construct(runner, count);
+
+            // Stepping the largest counts takes long enough to be opt-in.
+            if (count <= max_world) {
+                bench_world(runner, count);
+                bench_world_threads(runner, count);
+            }
+        }
+
+        if (out_path.empty()) {
+            std::cout << runner.to_json();
+        } else {
+            std::ofstream out(out_path);
+            if (!out)
+                throw std::runtime_error("bench cannot open output file \"" + out_path + "\".");
+            out << runner.to_json();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
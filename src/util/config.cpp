@@ -0,0 +1,122 @@
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <inipp.h>
+
+#include "config.hpp"
+
+Config::Config(const std::string& path) : path(path) {
+    reload();
+}
+
+Config& Config::shared() {
+    static Config config(SETTINGS_FILE);
+    return config;
+}
+
+void Config::reload() {
+    std::ifstream is(path);
+    if (!is)
+        throw std::runtime_error("Config::reload cannot open settings file \"" + path + "\".");
+
+    inipp::Ini<char> ini;
+    ini.parse(is);
+
+    for (Slot& slot : slots)
+        slot.present = false;
+
+    for (const auto& section : ini.sections) {
+        for (const auto& entry : section.second) {
+            const std::string name = slot_name(section.first, entry.first);
+            auto found = index.find(name);
+
+            if (found == index.end()) {
+                found = index.emplace(name, static_cast<Handle>(slots.size())).first;
+                slots.push_back({ section.first, entry.first, "", false, false, false, 0.0, false });
+            }
+
+            Slot& slot = slots[found->second];
+            const char* begin = entry.second.c_str();
+            char* end = nullptr;
+
+            slot.value = entry.second;
+            slot.present = true;
+
+            errno = 0;
+            slot.number = std::strtod(begin, &end);
+            slot.is_number = end != begin and *end == '\0' and errno != ERANGE;
+
+            slot.is_bool = slot.value == "true" or slot.value == "false";
+            slot.boolean = slot.value == "true";
+        }
+    }
+}
+
+bool Config::has(const std::string& section, const std::string& key) const {
+    const auto found = index.find(slot_name(section, key));
+    return found != index.end() and slots[found->second].present;
+}
+
+Config::Handle Config::handle(const std::string& section, const std::string& key) const {
+    const auto found = index.find(slot_name(section, key));
+
+    if (found == index.end())
+        throw std::runtime_error("Config::handle cannot find section \"" + section + "\", key \"" + key + "\" in \"" + path + "\".");
+
+    return found->second;
+}
+
+void Config::throw_value_error(const Slot& slot, const char* caller, const std::string& reason) const {
+    throw std::runtime_error(std::string(caller) + " cannot parse section \"" + slot.section + "\", key \"" + slot.key + "\": " + reason + ".");
+}
+
+const Config::Slot& Config::get_slot(Handle handle, const char* caller) const {
+    const Slot& slot = slots.at(handle);
+
+    if (!slot.present or slot.value.empty())
+        throw_value_error(slot, caller, "value is empty or key absent");
+
+    return slot;
+}
+
+const std::string& Config::get_string(Handle handle) const {
+    return get_slot(handle, "Config::get_string").value;
+}
+
+usize Config::get_usize(Handle handle) const {
+    const Slot& slot = get_slot(handle, "Config::get_usize");
+
+    if (!slot.is_number)
+        throw_value_error(slot, "Config::get_usize", "value is not a number");
+    if (slot.number < 0.0)
+        throw_value_error(slot, "Config::get_usize", "value is negative");
+    if (slot.number != std::floor(slot.number))
+        throw_value_error(slot, "Config::get_usize", "value is not an integer");
+    if (slot.number > static_cast<f64>(std::numeric_limits<usize>::max()))
+        throw_value_error(slot, "Config::get_usize", "value is out of range");
+
+    return static_cast<usize>(slot.number);
+}
+
+f32 Config::get_f32(Handle handle) const {
+    const Slot& slot = get_slot(handle, "Config::get_f32");
+
+    if (!slot.is_number)
+        throw_value_error(slot, "Config::get_f32", "value is not a number");
+    if (std::fabs(slot.number) > std::numeric_limits<f32>::max())
+        throw_value_error(slot, "Config::get_f32", "value is out of range");
+
+    return static_cast<f32>(slot.number);
+}
+
+bool Config::get_bool(Handle handle) const {
+    const Slot& slot = get_slot(handle, "Config::get_bool");
+
+    if (!slot.is_bool)
+        throw_value_error(slot, "Config::get_bool", "value is neither of \"true\", \"false\"");
+
+    return slot.boolean;
+}
\ No newline at end of file
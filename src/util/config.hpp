@@ -0,0 +1,88 @@
+#ifndef CONFIG_HPP_
+#define CONFIG_HPP_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "typedef.hpp"
+
+/**
+ * @brief In memory store of the settings file.
+ *
+ * The file is parsed once, when the shared store is first used, and again only on reload(). Every value is kept as
+ * a string, and is also parsed as a number and as a boolean right away, so typed lookups never touch the file or
+ * convert strings.
+ *
+ * Keys can be looked up by section and key name, or resolved once to a Handle, which is just an index into the
+ * store. Handles stay valid across reloads, if the key disappears from the file its lookups throw instead.
+ *
+ * @warning Lookups are safe from many threads, but reload() must not run while anything else reads the store.
+ */
+class Config {
+public:
+    typedef u32 Handle;
+
+private:
+    struct Slot {
+        std::string section;
+        std::string key;
+        std::string value;
+        bool present;
+        bool is_number;
+        bool is_bool;
+        f64 number;
+        bool boolean;
+    };
+
+    std::string path;
+    std::vector<Slot> slots;
+    std::unordered_map<std::string, Handle> index;
+
+    static std::string slot_name(const std::string& section, const std::string& key) { return section + '\n' + key; }
+
+    const Slot& get_slot(Handle handle, const char* caller) const;
+    [[noreturn]] void throw_value_error(const Slot& slot, const char* caller, const std::string& reason) const;
+
+public:
+    /**
+     * @brief Load a settings file.
+     * @param path The file to parse.
+     */
+    explicit Config(const std::string& path);
+
+    /**
+     * @brief Get the store of SETTINGS_FILE, loading it on first use.
+     */
+    static Config& shared();
+
+    const std::string& get_path() const { return path; }
+
+    /**
+     * @brief Parse the file again, updating the values of all the keys.
+     * @note Existing handles keep pointing to the same section and key.
+     */
+    void reload();
+
+    bool has(const std::string& section, const std::string& key) const;
+
+    /**
+     * @brief Resolve a key once, to look it up without hashing strings afterwards.
+     * @param section The section name, without brackets.
+     * @param key The key name.
+     * @return The handle of the key.
+     */
+    Handle handle(const std::string& section, const std::string& key) const;
+
+    const std::string& get_string(Handle handle) const;
+    usize get_usize(Handle handle) const;
+    f32 get_f32(Handle handle) const;
+    bool get_bool(Handle handle) const;
+
+    const std::string& get_string(const std::string& section, const std::string& key) const { return get_string(handle(section, key)); }
+    usize get_usize(const std::string& section, const std::string& key) const { return get_usize(handle(section, key)); }
+    f32 get_f32(const std::string& section, const std::string& key) const { return get_f32(handle(section, key)); }
+    bool get_bool(const std::string& section, const std::string& key) const { return get_bool(handle(section, key)); }
+};
+
+#endif
\ No newline at end of file
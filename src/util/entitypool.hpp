@@ -0,0 +1,170 @@
+#ifndef ENTITYPOOL_HPP_
+#define ENTITYPOOL_HPP_
+
+#include <stdexcept>
+#include <vector>
+
+#include "typedef.hpp"
+
+/**
+ * @brief Handle to an entity of an EntityPool, which stays valid until the entity is released.
+ */
+struct EntityHandle {
+    u32 slot;
+    u32 generation; // Zero is never live, so a default handle is always stale.
+
+    bool operator==(const EntityHandle& other) const { return slot == other.slot and generation == other.generation; }
+    bool operator!=(const EntityHandle& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Allocator of dense indexes with generational handles, for entity storage of a fixed capacity.
+ *
+ * The pool doesn't hold the entities, only the mapping between their handles and their indexes in the storage of the
+ * owner, such as the arrays of an AsteroidStore. The live entities always take the indexes [0, size()), so they can
+ * be iterated without skipping holes. Releasing an entity moves the last live one into its index, and the owner moves
+ * its storage the same way, so every operation is O(1).
+ *
+ * A handle is a slot, whose index follows the entity as it moves, and the generation of the slot when the entity was
+ * allocated. Releasing (or recycling) bumps the generation, so old handles stop resolving instead of pointing to
+ * whatever took the slot.
+ *
+ * When the pool is full, the policy decides what allocate() does: REFUSE fails, while RECYCLE_OLDEST hands out the
+ * index of the live entity allocated longest ago under a new handle, like a ring buffer overwriting its oldest entry.
+ */
+class EntityPool {
+public:
+    enum Policy {
+        REFUSE,
+        RECYCLE_OLDEST
+    };
+
+    static constexpr usize NO_INDEX = USIZEMAX;
+
+private:
+    enum : u32 { NO_SLOT = U32MAX }; // An enumerator, as the constructor binds it by reference.
+
+    Policy policy;
+    std::vector<u32> slot_indexes; // Dense index of the entity in each slot.
+    std::vector<u32> slot_generations;
+    std::vector<u32> index_slots; // Slot of the entity at each dense index, the first size() are live.
+    std::vector<u32> free_slots;
+    usize live_count;
+
+    // Live slots from the oldest allocation to the newest, as a doubly linked list.
+    std::vector<u32> older_slots;
+    std::vector<u32> newer_slots;
+    u32 oldest_slot;
+    u32 newest_slot;
+
+    void link_newest(u32 slot) {
+        older_slots[slot] = newest_slot;
+        newer_slots[slot] = NO_SLOT;
+        (newest_slot == NO_SLOT ? oldest_slot : newer_slots[newest_slot]) = slot;
+        newest_slot = slot;
+    }
+
+    void bump_generation(u32 slot) {
+        if (++slot_generations[slot] == 0)
+            slot_generations[slot] = 1;
+    }
+
+    void unlink(u32 slot) {
+        (older_slots[slot] == NO_SLOT ? oldest_slot : newer_slots[older_slots[slot]]) = newer_slots[slot];
+        (newer_slots[slot] == NO_SLOT ? newest_slot : older_slots[newer_slots[slot]]) = older_slots[slot];
+    }
+
+public:
+    /**
+     * @param capacity The most entities alive at once, which is also the size the owner gives its storage.
+     * @param policy What allocating does when the pool is full.
+     */
+    explicit EntityPool(usize capacity, Policy policy = RECYCLE_OLDEST)
+        : policy(policy), slot_indexes(capacity, NO_SLOT), slot_generations(capacity, 1), index_slots(capacity, NO_SLOT),
+          live_count(0), older_slots(capacity, NO_SLOT), newer_slots(capacity, NO_SLOT), oldest_slot(NO_SLOT), newest_slot(NO_SLOT) {
+        if (capacity >= NO_SLOT)
+            throw std::runtime_error("EntityPool::EntityPool cannot create pool: capacity doesn't fit a slot.");
+
+        // Popped from the back, so the first allocations take the lowest slots.
+        free_slots.reserve(capacity);
+        for (usize i = capacity; i > 0; --i)
+            free_slots.push_back(static_cast<u32>(i - 1));
+    }
+
+    usize size() const { return live_count; }
+    usize capacity() const { return slot_indexes.size(); }
+    bool is_full() const { return live_count == capacity(); }
+
+    Policy get_policy() const { return policy; }
+    void set_policy(Policy policy) { this->policy = policy; }
+
+    bool is_valid(EntityHandle handle) const {
+        return handle.slot < capacity() and slot_generations[handle.slot] == handle.generation and slot_indexes[handle.slot] != NO_SLOT;
+    }
+
+    /**
+     * @brief Get the dense index of an entity, or NO_INDEX if the handle is stale.
+     */
+    usize index_of(EntityHandle handle) const { return is_valid(handle) ? slot_indexes[handle.slot] : NO_INDEX; }
+
+    /**
+     * @brief Get the handle of the live entity at a dense index.
+     */
+    EntityHandle handle_of(usize index) const { return { index_slots[index], slot_generations[index_slots[index]] }; }
+
+    /**
+     * @brief Allocate an entity, or recycle the oldest one if the pool is full and the policy allows it.
+     * @param index Set to the dense index of the entity, NO_INDEX if the allocation was refused.
+     * @return The handle of the entity, stale if the allocation was refused.
+     */
+    EntityHandle allocate(usize& index) {
+        u32 slot;
+
+        if (live_count < capacity()) {
+            slot = free_slots.back();
+            free_slots.pop_back();
+            slot_indexes[slot] = static_cast<u32>(live_count);
+            index_slots[live_count++] = slot;
+        } else if (policy == RECYCLE_OLDEST and oldest_slot != NO_SLOT) {
+            slot = oldest_slot;
+            bump_generation(slot);
+            unlink(slot);
+        } else {
+            index = NO_INDEX;
+            return { NO_SLOT, 0 };
+        }
+
+        link_newest(slot);
+        index = slot_indexes[slot];
+        return { slot, slot_generations[slot] };
+    }
+
+    /**
+     * @brief Release an entity, moving the last live entity into its index.
+     *
+     * The owner then moves its storage the same way: the entity at size() (the old last index) goes into the
+     * returned index, unless the two are the same.
+     *
+     * @param handle The entity to release.
+     * @return The freed dense index, or NO_INDEX if the handle is stale.
+     */
+    usize release(EntityHandle handle) {
+        if (!is_valid(handle))
+            return NO_INDEX;
+
+        const u32 index = slot_indexes[handle.slot];
+        const u32 last_slot = index_slots[--live_count];
+
+        index_slots[index] = last_slot;
+        slot_indexes[last_slot] = index;
+
+        unlink(handle.slot);
+        slot_indexes[handle.slot] = NO_SLOT;
+        bump_generation(handle.slot);
+        free_slots.push_back(handle.slot);
+
+        return index;
+    }
+};
+
+#endif
\ No newline at end of file
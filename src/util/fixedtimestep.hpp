@@ -0,0 +1,61 @@
+#ifndef FIXEDTIMESTEP_HPP_
+#define FIXEDTIMESTEP_HPP_
+
+#include <cmath>
+
+#include "typedef.hpp"
+
+/**
+ * @brief Accumulator turning variable frame times into a whole amount of fixed simulation ticks.
+ *
+ * Every frame adds its duration to the accumulator, and each full tick of time is taken out of it to be simulated.
+ * If a frame would need more than the catch-up limit, the extra time is dropped instead, so a single hitch slows the
+ * game down for a moment rather than piling up more and more ticks per frame.
+ *
+ * What is left in the accumulator is less than a tick, and get_alpha() gives it as a fraction, to interpolate the
+ * rendering between the last two simulation states.
+ */
+class FixedTimestep {
+private:
+    f64 tick_seconds;
+    usize max_ticks;
+    f64 accumulator;
+    u64 tick_count;
+
+public:
+    /**
+     * @param tick_seconds The duration of a simulation tick.
+     * @param max_ticks The most ticks a single frame can run.
+     */
+    FixedTimestep(f64 tick_seconds, usize max_ticks) : tick_seconds(tick_seconds), max_ticks(max_ticks), accumulator(0.0), tick_count(0) {}
+
+    f64 get_tick_seconds() const { return tick_seconds; }
+    u64 get_tick_count() const { return tick_count; }
+
+    /**
+     * @brief Get how far the time is between the last tick and the next one, in [0, 1).
+     */
+    f32 get_alpha() const { return static_cast<f32>(accumulator / tick_seconds); }
+
+    /**
+     * @brief Add the time of a frame.
+     * @param frame_seconds The time since the last frame.
+     * @return The amount of ticks to simulate for this frame.
+     */
+    usize advance(f64 frame_seconds) {
+        accumulator += frame_seconds > 0.0 ? frame_seconds : 0.0;
+        usize ticks = static_cast<usize>(accumulator / tick_seconds);
+
+        if (ticks > max_ticks) {
+            ticks = max_ticks;
+            accumulator = std::fmod(accumulator, tick_seconds);
+        } else {
+            accumulator -= ticks * tick_seconds;
+        }
+
+        tick_count += ticks;
+        return ticks;
+    }
+};
+
+#endif
\ No newline at end of file
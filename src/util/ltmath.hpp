@@ -2,77 +2,190 @@
 #define LTMATH_HPP_
 
 #include <cmath>
-#include <array>
-#include <mutex>
+#include <cstdint>
 
 /**
  * @brief Utility namespace for trigonometric functions using a lookup table.
+ *
+ * The table holds TABLE_SIZE samples of the sine over a full turn, plus a quarter turn and one more sample, so that
+ * the cosine can read the same table a quarter turn ahead, and interpolation never has to wrap around. It is built
+ * by the compiler, so there is nothing to initialize at runtime.
+ *
+ * Lookups interpolate linearly between the two nearest samples. With a sample step of h = 2 * PI / TABLE_SIZE, the
+ * interpolation error is at most h^2 / 8, about 4.7e-6 for 1024 samples, and MAX_ERROR adds some room for float
+ * rounding. The angle is scaled to table steps in double precision, so the bound holds for angles up to many
+ * thousands of turns.
  */
 namespace LookupTableMath {
-    static constexpr int TABLE_SIZE = 40;
+    static constexpr int TABLE_BITS = 10;
+    static constexpr int TABLE_SIZE = 1 << TABLE_BITS;
+    static constexpr int TABLE_MASK = TABLE_SIZE - 1;
+    static constexpr int QUARTER_TURN = TABLE_SIZE / 4;
+    static constexpr float MAX_ERROR = 5e-6f;
 
-    static std::array<float, TABLE_SIZE> sin_table;
-    static std::array<float, TABLE_SIZE> cos_table;
-    static std::once_flag init_flag;
+    namespace detail {
+        static constexpr double PI = 3.14159265358979323846;
+        static constexpr double STEPS_PER_RAD = TABLE_SIZE / (2 * PI);
 
-    /**
-     * @brief Initialize the lookup table.
-     */
-    static void ltinit() {
-        for (int i = 0; i < TABLE_SIZE; ++i) {
-            sin_table[i] = std::sinf(i * 2 * M_PI / TABLE_SIZE);
-            cos_table[i] = std::cosf(i * 2 * M_PI / TABLE_SIZE);
+        /**
+         * @brief Taylor series of the sine, adding terms until they are far below double precision.
+         */
+        constexpr double sin_series(double x2, double term, double sum, int power) {
+            return power > 35 ? sum : sin_series(x2, -term * x2 / ((power + 1) * (power + 2)), sum + term, power + 2);
         }
-    }
+
+        constexpr double wrap_angle(double rad) {
+            return rad > PI ? wrap_angle(rad - 2 * PI) : rad;
+        }
+
+        constexpr double sin_sample(double rad) {
+            return sin_series(rad * rad, rad, 0.0, 1);
+        }
+
+        constexpr float table_entry(int i) {
+            return static_cast<float>(sin_sample(wrap_angle(i * 2 * PI / TABLE_SIZE)));
+        }
+
+        /* C++11 has no std::index_sequence, the list of indexes is built by halves to keep the recursion shallow. */
+
+        template <int... I>
+        struct IndexList {};
+
+        template <typename A, typename B>
+        struct ConcatIndexes;
+
+        template <int... A, int... B>
+        struct ConcatIndexes<IndexList<A...>, IndexList<B...>> {
+            typedef IndexList<A..., (static_cast<int>(sizeof...(A)) + B)...> type;
+        };
+
+        template <int N>
+        struct MakeIndexes {
+            typedef typename ConcatIndexes<typename MakeIndexes<N / 2>::type, typename MakeIndexes<N - N / 2>::type>::type type;
+        };
+
+        template <>
+        struct MakeIndexes<0> { typedef IndexList<> type; };
+
+        template <>
+        struct MakeIndexes<1> { typedef IndexList<0> type; };
+
+        template <typename Indexes>
+        struct SinTable;
+
+        template <int... I>
+        struct SinTable<IndexList<I...>> {
+            static constexpr float values[sizeof...(I)] = { table_entry(I)... };
+        };
+
+        template <int... I>
+        constexpr float SinTable<IndexList<I...>>::values[sizeof...(I)];
+
+        typedef SinTable<MakeIndexes<TABLE_SIZE + QUARTER_TURN + 1>::type> Table;
+
+        /**
+         * @brief Interpolate the table between a sample and the next one.
+         */
+        static inline float sample(int index, float frac) {
+            const float a = Table::values[index];
+            const float b = Table::values[index + 1];
+            return a + (b - a) * frac;
+        }
+
+        /**
+         * @brief Split any angle into a sample index in [0, TABLE_SIZE) and the fraction to the next sample.
+         * @note Flooring is done by comparison, so that negative angles don't need a branch.
+         */
+        static inline int reduce(float rad, float& frac) {
+            const double steps = rad * STEPS_PER_RAD;
+            std::int64_t whole = static_cast<std::int64_t>(steps);
+            whole -= steps < static_cast<double>(whole);
+            frac = static_cast<float>(steps - static_cast<double>(whole));
+            return static_cast<int>(whole & TABLE_MASK);
+        }
+
+        /**
+         * @brief Split an angle in [0, 2 * PI) into a sample index and fraction, skipping the wrap around.
+         */
+        static inline int reduce_q(float rad, float& frac) {
+            const float steps = rad * static_cast<float>(STEPS_PER_RAD);
+            const int whole = static_cast<int>(steps);
+            frac = steps - static_cast<float>(whole);
+            return whole & TABLE_MASK;
+        }
+    };
 
     /**
      * @brief Get the sine of an angle in radians.
      * @param rad The angle in radians.
-     * @return The sine of the angle.
+     * @return The sine of the angle, within MAX_ERROR.
      */
-    static float ltsinf(float rad) {
-        std::call_once(init_flag, ltinit);
-        rad = std::fmod(rad, 2 * M_PI);
-        int index = static_cast<int>(rad * TABLE_SIZE / (2 * M_PI)) % TABLE_SIZE;
-        if (index < 0)
-            index += TABLE_SIZE;
-        return sin_table[index];
+    static inline float ltsinf(float rad) {
+        float frac;
+        const int index = detail::reduce(rad, frac);
+        return detail::sample(index, frac);
     }
 
     /**
      * @brief Get the sine of an angle in radians, with a range of [0, 2 * PI).
      * @param rad The angle in radians.
-     * @return The sine of the angle.
+     * @return The sine of the angle, within MAX_ERROR.
      * @warning This function will return wrong values for angles outside the range [0, 2 * PI).
      */
-    static float ltsinf_q(float rad) {
-        std::call_once(init_flag, ltinit);
-        return sin_table[static_cast<int>(rad * TABLE_SIZE / (2 * M_PI))];
+    static inline float ltsinf_q(float rad) {
+        float frac;
+        const int index = detail::reduce_q(rad, frac);
+        return detail::sample(index, frac);
     }
 
     /**
      * @brief Get the cosine of an angle in radians.
      * @param rad The angle in radians.
-     * @return The cosine of the angle.
+     * @return The cosine of the angle, within MAX_ERROR.
      */
-    static float ltcosf(float rad) {
-        std::call_once(init_flag, ltinit);
-        rad = std::fmod(rad, 2 * M_PI);
-        int index = static_cast<int>(rad * TABLE_SIZE / (2 * M_PI)) % TABLE_SIZE;
-        if (index < 0)
-            index += TABLE_SIZE;
-        return cos_table[index];
+    static inline float ltcosf(float rad) {
+        float frac;
+        const int index = detail::reduce(rad, frac);
+        return detail::sample(index + QUARTER_TURN, frac);
     }
 
     /**
      * @brief Get the cosine of an angle in radians, with a range of [0, 2 * PI).
      * @param rad The angle in radians.
-     * @return The cosine of the angle.
+     * @return The cosine of the angle, within MAX_ERROR.
+     * @warning This function will return wrong values for angles outside the range [0, 2 * PI).
+     */
+    static inline float ltcosf_q(float rad) {
+        float frac;
+        const int index = detail::reduce_q(rad, frac);
+        return detail::sample(index + QUARTER_TURN, frac);
+    }
+
+    /**
+     * @brief Get both the sine and the cosine of an angle in radians, reducing the angle only once.
+     * @param rad The angle in radians.
+     * @param sin Set to the sine of the angle, within MAX_ERROR.
+     * @param cos Set to the cosine of the angle, within MAX_ERROR.
+     */
+    static inline void ltsincosf(float rad, float& sin, float& cos) {
+        float frac;
+        const int index = detail::reduce(rad, frac);
+        sin = detail::sample(index, frac);
+        cos = detail::sample(index + QUARTER_TURN, frac);
+    }
+
+    /**
+     * @brief Get both the sine and the cosine of an angle in radians, with a range of [0, 2 * PI).
+     * @param rad The angle in radians.
+     * @param sin Set to the sine of the angle, within MAX_ERROR.
+     * @param cos Set to the cosine of the angle, within MAX_ERROR.
      * @warning This function will return wrong values for angles outside the range [0, 2 * PI).
      */
-    static float ltcosf_q(float rad) {
-        std::call_once(init_flag, ltinit);
-        return cos_table[static_cast<int>(rad * TABLE_SIZE / (2 * M_PI))];
+    static inline void ltsincosf_q(float rad, float& sin, float& cos) {
+        float frac;
+        const int index = detail::reduce_q(rad, frac);
+        sin = detail::sample(index, frac);
+        cos = detail::sample(index + QUARTER_TURN, frac);
     }
 };
 
@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+#include "profiler.hpp"
+
+std::mutex& Profiler::rings_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+/* Rings are never freed, so that a thread exiting (like the workers of a replaced WorkerPool) keeps its zones. */
+std::vector<Profiler::ThreadRing*>& Profiler::rings() {
+    static std::vector<ThreadRing*> rings;
+    return rings;
+}
+
+Profiler::ThreadRing* Profiler::register_thread() {
+    std::lock_guard<std::mutex> lock(rings_mutex());
+
+    rings().push_back(new ThreadRing(static_cast<u32>(rings().size())));
+    return rings().back();
+}
+
+usize Profiler::write_chrome_trace(const std::string& path) {
+    std::ofstream out(path);
+    if (!out)
+        throw std::runtime_error("Profiler::write_chrome_trace cannot open file \"" + path + "\".");
+
+    std::lock_guard<std::mutex> lock(rings_mutex());
+
+    // Timestamps start from the oldest zone still recorded.
+    u64 origin_ns = U64MAX;
+    for (const ThreadRing* ring : rings()) {
+        const u64 count = ring->count.load(std::memory_order_acquire);
+        for (u64 e = count > RING_CAPACITY ? count - RING_CAPACITY : 0; e < count; ++e)
+            origin_ns = std::min(origin_ns, ring->events[e & (RING_CAPACITY - 1)].begin_ns);
+    }
+
+    usize written = 0;
+    out.precision(3);
+    out << std::fixed << "{\"traceEvents\":[";
+
+    for (const ThreadRing* ring : rings()) {
+        const u64 count = ring->count.load(std::memory_order_acquire);
+
+        out << (ring == rings().front() ? "\n" : ",\n")
+            << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->thread_id << ",\"args\":{\"name\":\""
+            << "thread " << ring->thread_id << "\"}}";
+
+        for (u64 e = count > RING_CAPACITY ? count - RING_CAPACITY : 0; e < count; ++e) {
+            const Event& event = ring->events[e & (RING_CAPACITY - 1)];
+
+            out << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->thread_id
+                << ",\"ts\":" << (event.begin_ns - origin_ns) / 1000.0 << ",\"dur\":" << (event.end_ns - event.begin_ns) / 1000.0 << "}";
+            ++written;
+        }
+    }
+
+    out << "\n]}\n";
+    return written;
+}
\ No newline at end of file
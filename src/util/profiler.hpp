@@ -0,0 +1,106 @@
+#ifndef PROFILER_HPP_
+#define PROFILER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "typedef.hpp"
+
+/**
+ * @brief Recorder of timed zones, exported as a Chrome trace (chrome://tracing or ui.perfetto.dev).
+ *
+ * Every thread records into its own ring buffer, which is registered the first time the thread opens a zone, so
+ * recording a zone takes no lock: it reads the clock twice and writes a single event. When a ring is full the oldest
+ * events are overwritten, so the export always holds the latest RING_CAPACITY zones of every thread.
+ *
+ * Zones are placed with the PROFILE_ZONE macro, which compiles to nothing unless PROFILE_ZONES is defined.
+ *
+ * @warning Exporting reads the rings of all threads, so it should only run while the other threads are idle, such as
+ * between two frames, when the WorkerPool threads are waiting for their next batch.
+ */
+class Profiler {
+public:
+    static constexpr usize RING_CAPACITY = 1 << 16;
+
+    struct Event {
+        const char* name;
+        u64 begin_ns;
+        u64 end_ns;
+    };
+
+private:
+    struct ThreadRing {
+        u32 thread_id;
+        std::atomic<u64> count;
+        std::vector<Event> events;
+
+        explicit ThreadRing(u32 thread_id) : thread_id(thread_id), count(0), events(RING_CAPACITY) {}
+
+        void record(const char* name, u64 begin_ns, u64 end_ns) {
+            const u64 n = count.load(std::memory_order_relaxed);
+            events[n & (RING_CAPACITY - 1)] = { name, begin_ns, end_ns };
+            count.store(n + 1, std::memory_order_release);
+        }
+    };
+
+    static std::mutex& rings_mutex();
+    static std::vector<ThreadRing*>& rings();
+    static ThreadRing* register_thread();
+
+    static ThreadRing& thread_ring() {
+        static thread_local ThreadRing* ring = nullptr;
+        if (!ring)
+            ring = register_thread();
+        return *ring;
+    }
+
+public:
+    /**
+     * @brief Scoped zone, timing the lifetime of the object.
+     */
+    class Zone {
+    private:
+        ThreadRing& ring;
+        const char* name;
+        u64 begin_ns;
+
+    public:
+        /**
+         * @param name The name shown in the trace, which must outlive the export, such as a string literal.
+         */
+        explicit Zone(const char* name) : ring(thread_ring()), name(name), begin_ns(now_ns()) {}
+        ~Zone() { ring.record(name, begin_ns, now_ns()); }
+
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+    };
+
+    static u64 now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * @brief Add a finished zone to the ring of the calling thread.
+     */
+    static void record(const char* name, u64 begin_ns, u64 end_ns) { thread_ring().record(name, begin_ns, end_ns); }
+
+    /**
+     * @brief Write the recorded zones of all threads as Chrome trace event JSON.
+     * @param path The file to write.
+     * @return The amount of zones written.
+     */
+    static usize write_chrome_trace(const std::string& path);
+};
+
+#ifdef PROFILE_ZONES
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) const Profiler::Zone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#endif
+
+#endif
\ No newline at end of file
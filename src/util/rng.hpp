@@ -0,0 +1,93 @@
+#ifndef RNG_HPP_
+#define RNG_HPP_
+
+#include "typedef.hpp"
+
+/**
+ * @brief Small seedable random generator (xoshiro128**), with independent streams.
+ *
+ * A generator is made from a seed and a stream number, expanded into its 128 bit state by splitmix64, so the same
+ * seed gives unrelated sequences on different streams. Each subsystem draws from its own stream, and work split over
+ * threads or items can take one stream per index with stream(), so the results never depend on who drew first.
+ *
+ * A generator is a plain value with no shared state, so it is only as thread safe as the object holding it.
+ */
+class Rng {
+public:
+    // Subsystem streams, combined with an index by stream().
+    static constexpr u64 SHAPE_STREAM = 1;
+    static constexpr u64 WORLD_STREAM = 2;
+    static constexpr u64 BENCH_STREAM = 3;
+    static constexpr u64 CHUNK_STREAM = 4;
+    static constexpr u64 TEST_STREAM = 5;
+
+    static constexpr u64 DEFAULT_SEED = 1;
+
+private:
+    u32 state[4];
+
+    static u64 splitmix64(u64& x) {
+        u64 z = (x += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    static u32 rotl(u32 x, int k) { return (x << k) | (x >> (32 - k)); }
+
+public:
+    /**
+     * @param seed The seed of the whole session.
+     * @param stream The stream of the generator, such as a subsystem or one of its threads.
+     */
+    explicit Rng(u64 seed = DEFAULT_SEED, u64 stream = 0) {
+        // The stream moves the splitmix64 counter by an odd constant unlike its own increment, so streams don't share outputs.
+        u64 x = seed ^ (stream * 0xd1b54a32d192ed03ull);
+        const u64 a = splitmix64(x);
+        const u64 b = splitmix64(x);
+
+        state[0] = static_cast<u32>(a);
+        state[1] = static_cast<u32>(a >> 32);
+        state[2] = static_cast<u32>(b);
+        state[3] = static_cast<u32>(b >> 32) | 1; // Never all zero.
+    }
+
+    /**
+     * @brief Get the stream number of an item (or thread) of a subsystem.
+     */
+    static constexpr u64 stream(u64 subsystem, u64 index) { return subsystem << 32 | index; }
+
+    u32 next_u32() {
+        const u32 result = rotl(state[1] * 5, 7) * 9;
+        const u32 t = state[1] << 9;
+
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 11);
+
+        return result;
+    }
+
+    /**
+     * @brief Get a float in [0, 1), from the top 24 bits of the next output.
+     */
+    f32 next_f32() { return static_cast<f32>(next_u32() >> 8) * (1.0f / 16777216.0f); }
+
+    /**
+     * @brief Get a float in [low, high).
+     */
+    f32 next_f32(f32 low, f32 high) { return low + next_f32() * (high - low); }
+
+    /**
+     * @brief Get an integer in [low, high], by scaling the next output, which is biased by at most the size of the range over 2^32.
+     */
+    i32 next_i32(i32 low, i32 high) {
+        const u64 range = static_cast<u64>(static_cast<i64>(high) - low) + 1;
+        return static_cast<i32>(low + static_cast<i64>((next_u32() * range) >> 32));
+    }
+};
+
+#endif
\ No newline at end of file
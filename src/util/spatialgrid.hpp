@@ -0,0 +1,201 @@
+#ifndef SPATIALGRID_HPP_
+#define SPATIALGRID_HPP_
+
+#include <cmath>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include "typedef.hpp"
+#include "workerpool.hpp"
+#include "profiler.hpp"
+
+/**
+ * @brief Uniform grid broadphase for axis aligned bounding boxes.
+ *
+ * Every inserted box is registered in each grid cell it overlaps, then find_pairs() sorts the registrations by
+ * cell and reports every pair of indexes that share at least one cell. The pairs are sorted and unique, so they
+ * can be processed in the same order as a nested i < j loop would.
+ *
+ * The grid is sparse (cells are only keys), so there is no limit on the world extent, and the cost of a rebuild
+ * is linear in the amount of boxes, plus the sort.
+ *
+ * The rebuild can also be spread over a WorkerPool, with insert_all() and find_pairs(pool), giving exactly the
+ * same pairs as the single threaded path.
+ *
+ * @note For the best results, the cell size should be around the size of the largest box inserted, so that
+ * each box overlaps at most four cells.
+ */
+class SpatialGrid {
+public:
+    typedef std::pair<u32, u32> IndexPair;
+
+private:
+    struct CellEntry {
+        u64 key;
+        u32 index;
+
+        bool operator<(const CellEntry& other) const {
+            return key < other.key or (key == other.key and index < other.index);
+        }
+    };
+
+    static constexpr usize INSERT_GRAIN = 2048;
+    static constexpr usize PAIR_CHUNKS = 16;
+    static constexpr usize PARALLEL_MIN_ENTRIES = 4096;
+
+    f32 cell_size;
+    f32 inv_cell_size;
+    std::vector<CellEntry> entries;
+    std::vector<IndexPair> pairs;
+    std::vector<usize> chunk_offsets;
+    std::vector<std::vector<IndexPair>> chunk_pairs;
+
+    i32 cell_coord(f32 v) const { return static_cast<i32>(std::floor(v * inv_cell_size)); }
+
+    static u64 cell_key(i32 cx, i32 cy) {
+        return (static_cast<u64>(static_cast<u32>(cx)) << 32) | static_cast<u64>(static_cast<u32>(cy));
+    }
+
+    usize cell_count(const f32_2* bounding_box) const {
+        return (cell_coord(bounding_box[1].x) - cell_coord(bounding_box[0].x) + 1) * (cell_coord(bounding_box[1].y) - cell_coord(bounding_box[0].y) + 1);
+    }
+
+    CellEntry* write_entries(CellEntry* out, u32 index, const f32_2* bounding_box) const {
+        const i32 x0 = cell_coord(bounding_box[0].x);
+        const i32 y0 = cell_coord(bounding_box[0].y);
+        const i32 x1 = cell_coord(bounding_box[1].x);
+        const i32 y1 = cell_coord(bounding_box[1].y);
+
+        for (i32 cx = x0; cx <= x1; ++cx)
+            for (i32 cy = y0; cy <= y1; ++cy)
+                *out++ = { cell_key(cx, cy), index };
+
+        return out;
+    }
+
+    /**
+     * @brief Report the pairs of every cell run starting in [begin, end) of the sorted entries.
+     */
+    void collect_pairs(usize begin, usize end, std::vector<IndexPair>& out) const {
+        while (begin > 0 and begin < entries.size() and entries[begin - 1].key == entries[begin].key)
+            ++begin;
+
+        for (usize run_start = begin; run_start < end;) {
+            usize run_end = run_start + 1;
+            while (run_end < entries.size() and entries[run_end].key == entries[run_start].key)
+                ++run_end;
+
+            for (usize i = run_start; i < run_end; ++i)
+                for (usize j = i + 1; j < run_end; ++j)
+                    out.push_back({ entries[i].index, entries[j].index });
+
+            run_start = run_end;
+        }
+    }
+
+public:
+    SpatialGrid(f32 cell_size) { set_cell_size(cell_size); }
+
+    f32 get_cell_size() const { return cell_size; }
+
+    void set_cell_size(f32 cell_size) {
+        this->cell_size = cell_size;
+        inv_cell_size = 1.0f / cell_size;
+    }
+
+    void clear() { entries.clear(); }
+
+    /**
+     * @brief Register a bounding box in all the cells it overlaps.
+     * @param index The index reported back by find_pairs().
+     * @param bounding_box The minimum and maximum corners of the box.
+     */
+    void insert(u32 index, const f32_2* bounding_box) {
+        const usize cells = cell_count(bounding_box);
+        entries.resize(entries.size() + cells);
+        write_entries(&entries[entries.size() - cells], index, bounding_box);
+    }
+
+    /**
+     * @brief Register many bounding boxes at once, spreading the work over a pool.
+     *
+     * The entries end up in the same order as calling insert() for every box in index order.
+     *
+     * @param pool The pool to run on.
+     * @param count The amount of boxes.
+     * @param bounding_boxes The minimum and maximum corners of every box, one after the other.
+     * @param skip If not null, the boxes whose flag is set are left out.
+     */
+    void insert_all(WorkerPool& pool, usize count, const f32_2* bounding_boxes, const u8* skip = nullptr) {
+        PROFILE_ZONE("SpatialGrid::insert_all");
+
+        const usize chunks = (count + INSERT_GRAIN - 1) / INSERT_GRAIN;
+        chunk_offsets.assign(chunks + 1, 0);
+
+        pool.parallel_for(count, INSERT_GRAIN, [&](usize begin, usize end) {
+            usize cells = 0;
+            for (usize i = begin; i < end; ++i)
+                if (!skip or !skip[i])
+                    cells += cell_count(&bounding_boxes[2 * i]);
+            chunk_offsets[begin / INSERT_GRAIN + 1] = cells;
+        });
+
+        const usize first = entries.size();
+        for (usize chunk = 0; chunk < chunks; ++chunk)
+            chunk_offsets[chunk + 1] += chunk_offsets[chunk];
+        entries.resize(first + chunk_offsets[chunks]);
+
+        pool.parallel_for(count, INSERT_GRAIN, [&](usize begin, usize end) {
+            CellEntry* out = entries.data() + first + chunk_offsets[begin / INSERT_GRAIN];
+            for (usize i = begin; i < end; ++i)
+                if (!skip or !skip[i])
+                    out = write_entries(out, i, &bounding_boxes[2 * i]);
+        });
+    }
+
+    /**
+     * @brief Find all the pairs of indexes sharing at least one cell.
+     * @return Sorted, unique pairs, with the first index always lower than the second.
+     */
+    const std::vector<IndexPair>& find_pairs() {
+        pairs.clear();
+        std::sort(entries.begin(), entries.end());
+        collect_pairs(0, entries.size(), pairs);
+
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+        return pairs;
+    }
+
+    /**
+     * @brief Find all the pairs of indexes sharing at least one cell, spreading the work over a pool.
+     * @return The same pairs as find_pairs().
+     */
+    const std::vector<IndexPair>& find_pairs(WorkerPool& pool) {
+        PROFILE_ZONE("SpatialGrid::find_pairs");
+
+        if (entries.size() < PARALLEL_MIN_ENTRIES or pool.get_thread_count() == 1)
+            return find_pairs();
+
+        pool.sort(entries);
+
+        chunk_pairs.resize(PAIR_CHUNKS);
+        pool.run(PAIR_CHUNKS, [&](usize chunk) {
+            chunk_pairs[chunk].clear();
+            collect_pairs(chunk * entries.size() / PAIR_CHUNKS, (chunk + 1) * entries.size() / PAIR_CHUNKS, chunk_pairs[chunk]);
+        });
+
+        pairs.clear();
+        for (const std::vector<IndexPair>& chunk : chunk_pairs)
+            pairs.insert(pairs.end(), chunk.begin(), chunk.end());
+
+        pool.sort(pairs);
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+        return pairs;
+    }
+};
+
+#endif
\ No newline at end of file
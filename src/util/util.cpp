@@ -1,4 +1,5 @@
 #include "util.hpp"
+#include "config.hpp"
 
 /*std::string util::abs_dir() {
     char buffer[PATH_BUFFER_SIZE];
@@ -13,50 +14,17 @@
 }*/
 
 std::string util::cfg_string(const std::string& section, const std::string& key) {
-    inipp::Ini<char> ini;
-    std::ifstream is(SETTINGS_FILE);
-    ini.parse(is);
-
-    std::string value;
-    inipp::get_value(ini.sections[section], key, value);
-
-    if (value.empty())
-        throw std::runtime_error("util::cfg_string cannot parse section \"" + section + "\", key \"" + key + "\": value is empty or key absent.");
-
-    return value;
+    return Config::shared().get_string(section, key);
 }
 
 usize util::cfg_usize(const std::string& section, const std::string& key) {
-    std::string cfgStr = cfg_string(section, key);
-
-    if (cfgStr[0] == '-')
-        throw std::runtime_error("util::cfg_usize cannot parse section \"" + section + "\", key \"" + key + "\": value is negative.");
-
-    try {
-        return std::stoul(cfgStr);
-    } catch (const std::invalid_argument& e) {
-        throw std::runtime_error("util::cfg_usize cannot parse section \"" + section + "\", key \"" + key + "\": value is not a number.");
-    } catch (const std::out_of_range& e) {
-        throw std::runtime_error("util::cfg_usize cannot parse section \"" + section + "\", key \"" + key + "\": value is out of range.");
-    }
+    return Config::shared().get_usize(section, key);
 }
 
 f32 util::cfg_f32(const std::string& section, const std::string& key) {
-    try {
-        return std::stof(cfg_string(section, key));
-    } catch (const std::invalid_argument& e) {
-        throw std::runtime_error("util::cfg_f32 cannot parse section \"" + section + "\", key \"" + key + "\": value is not a number.");
-    } catch (const std::out_of_range& e) {
-        throw std::runtime_error("util::cfg_f32 cannot parse section \"" + section + "\", key \"" + key + "\": value is out of range.");
-    }
+    return Config::shared().get_f32(section, key);
 }
 
 bool util::cfg_bool(const std::string& section, const std::string& key) {
-    std::string value = cfg_string(section, key);
-    if (value == "true")
-        return true;
-    if (value == "false")
-        return false;
-    
-    throw std::runtime_error("util::cfg_bool cannot parse section \"" + section + "\", key \"" + key + "\": value is neither of \"true\", \"false\".");
+    return Config::shared().get_bool(section, key);
 }
\ No newline at end of file
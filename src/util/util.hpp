@@ -8,13 +8,14 @@
 #include <stdexcept>
 #include <unistd.h>
 #include <raylib.h>
-#include <inipp.h>
 
 #include "typedef.hpp"
 
 class util {
 public:
     //static std::string abs_dir();
+
+    /* Shorthands for the shared Config store, which only reads the settings file once. */
     static std::string cfg_string(const std::string& section, const std::string& key);
     static usize cfg_usize(const std::string& section, const std::string& key);
     static f32 cfg_f32(const std::string& section, const std::string& key);
@@ -37,21 +38,6 @@ public:
         value = std::min(value, highLimit);
         return original - value;
     }
-
-    static inline f32 randf() {
-        return static_cast<f32>(GetRandomValue(0, RAND_MAX)) / static_cast<f32>(RAND_MAX);
-    }
-
-    static inline int randi(const int low, const int high) {
-        return GetRandomValue(low, high);
-    }
-
-    static inline void offsetv(Vector2* vec, usize n, const Vector2& offset) {
-        for (usize i = 0; i < n; ++i) {
-            vec[i].x += offset.x;
-            vec[i].y += offset.y;
-        }
-    }
 };
 
 #endif
\ No newline at end of file
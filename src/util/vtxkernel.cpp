@@ -0,0 +1,201 @@
+#include "vtxkernel.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define VTXKERNEL_X86
+    #include <immintrin.h>
+#endif
+
+namespace {
+    void transform_scalar(const VertexKernel::Job* jobs, usize count) {
+        for (usize j = 0; j < count; ++j) {
+            const VertexKernel::Job& job = jobs[j];
+            const f32_2* vertexes = job.vertexes;
+            f32_2* vtx = job.rel_vertexes;
+            f32_2* bbox = job.bounding_box;
+
+            for (usize i = 0; i < job.vtx_count; ++i) {
+                const f32 rx = vertexes[i].x * job.cos_angle + vertexes[i].y * -job.sin_angle;
+                const f32 ry = vertexes[i].y * job.cos_angle + vertexes[i].x * job.sin_angle;
+                vtx[i] = { rx + job.position.x, ry + job.position.y };
+            }
+
+            bbox[0] = vtx[0];
+            bbox[1] = vtx[0];
+
+            for (usize i = 1; i < job.vtx_count; ++i) {
+                bbox[0].x = vtx[i].x < bbox[0].x ? vtx[i].x : bbox[0].x;
+                bbox[0].y = vtx[i].y < bbox[0].y ? vtx[i].y : bbox[0].y;
+                bbox[1].x = vtx[i].x > bbox[1].x ? vtx[i].x : bbox[1].x;
+                bbox[1].y = vtx[i].y > bbox[1].y ? vtx[i].y : bbox[1].y;
+            }
+
+            vtx[job.vtx_count] = vtx[0];
+        }
+    }
+
+#ifdef VTXKERNEL_X86
+    /*
+     * Vertexes are loaded as interleaved x, y pairs. With v = [x, y] and its swap w = [y, x], the rotation is
+     * v * [c, c] + w * [-s, s], which is the same product and sum order as the scalar path.
+     */
+
+    __attribute__((target("sse2")))
+    inline void store_bbox_sse2(f32_2* bbox, __m128 acc_min, __m128 acc_max) {
+        acc_min = _mm_min_ps(_mm_movehl_ps(acc_min, acc_min), acc_min);
+        acc_max = _mm_max_ps(_mm_movehl_ps(acc_max, acc_max), acc_max);
+        _mm_storel_pi(reinterpret_cast<__m64*>(&bbox[0]), acc_min);
+        _mm_storel_pi(reinterpret_cast<__m64*>(&bbox[1]), acc_max);
+    }
+
+    __attribute__((target("sse2")))
+    inline __m128 rotate_sse2(__m128 v, __m128 cos_v, __m128 sin_v, __m128 pos_v) {
+        const __m128 w = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(v, cos_v), _mm_mul_ps(w, sin_v)), pos_v);
+    }
+
+    __attribute__((target("sse2")))
+    void transform_sse2(const VertexKernel::Job* jobs, usize count) {
+        for (usize j = 0; j < count; ++j) {
+            const VertexKernel::Job& job = jobs[j];
+            const f32* src = reinterpret_cast<const f32*>(job.vertexes);
+            f32* dst = reinterpret_cast<f32*>(job.rel_vertexes);
+            const usize n = job.vtx_count;
+
+            const __m128 cos_v = _mm_set1_ps(job.cos_angle);
+            const __m128 sin_v = _mm_set_ps(job.sin_angle, -job.sin_angle, job.sin_angle, -job.sin_angle);
+            const __m128 pos_v = _mm_set_ps(job.position.y, job.position.x, job.position.y, job.position.x);
+
+            __m128 first = rotate_sse2(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const f64*>(src))), cos_v, sin_v, pos_v);
+            first = _mm_movelh_ps(first, first);
+            __m128 acc_min = first;
+            __m128 acc_max = first;
+
+            usize i = 0;
+            for (; i + 2 <= n; i += 2) {
+                const __m128 r = rotate_sse2(_mm_loadu_ps(src + 2 * i), cos_v, sin_v, pos_v);
+                _mm_storeu_ps(dst + 2 * i, r);
+                acc_min = _mm_min_ps(r, acc_min);
+                acc_max = _mm_max_ps(r, acc_max);
+            }
+            for (; i < n; ++i) {
+                __m128 r = rotate_sse2(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const f64*>(src + 2 * i))), cos_v, sin_v, pos_v);
+                _mm_store_sd(reinterpret_cast<f64*>(dst + 2 * i), _mm_castps_pd(r));
+                r = _mm_movelh_ps(r, r);
+                acc_min = _mm_min_ps(r, acc_min);
+                acc_max = _mm_max_ps(r, acc_max);
+            }
+
+            store_bbox_sse2(job.bounding_box, acc_min, acc_max);
+            job.rel_vertexes[n] = job.rel_vertexes[0];
+        }
+    }
+
+    __attribute__((target("avx2")))
+    void transform_avx2(const VertexKernel::Job* jobs, usize count) {
+        for (usize j = 0; j < count; ++j) {
+            const VertexKernel::Job& job = jobs[j];
+            const f32* src = reinterpret_cast<const f32*>(job.vertexes);
+            f32* dst = reinterpret_cast<f32*>(job.rel_vertexes);
+            const usize n = job.vtx_count;
+
+            const __m256 cos_v8 = _mm256_set1_ps(job.cos_angle);
+            const __m256 sin_v8 = _mm256_set_ps(
+                job.sin_angle, -job.sin_angle, job.sin_angle, -job.sin_angle,
+                job.sin_angle, -job.sin_angle, job.sin_angle, -job.sin_angle
+            );
+            const __m256 pos_v8 = _mm256_set_ps(
+                job.position.y, job.position.x, job.position.y, job.position.x,
+                job.position.y, job.position.x, job.position.y, job.position.x
+            );
+            const __m128 cos_v = _mm256_castps256_ps128(cos_v8);
+            const __m128 sin_v = _mm256_castps256_ps128(sin_v8);
+            const __m128 pos_v = _mm256_castps256_ps128(pos_v8);
+
+            __m128 first = rotate_sse2(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const f64*>(src))), cos_v, sin_v, pos_v);
+            first = _mm_movelh_ps(first, first);
+            __m256 acc_min8 = _mm256_set_m128(first, first);
+            __m256 acc_max8 = acc_min8;
+
+            usize i = 0;
+            for (; i + 4 <= n; i += 4) {
+                const __m256 v = _mm256_loadu_ps(src + 2 * i);
+                const __m256 w = _mm256_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1));
+                const __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(v, cos_v8), _mm256_mul_ps(w, sin_v8)), pos_v8);
+                _mm256_storeu_ps(dst + 2 * i, r);
+                acc_min8 = _mm256_min_ps(r, acc_min8);
+                acc_max8 = _mm256_max_ps(r, acc_max8);
+            }
+
+            __m128 acc_min = _mm_min_ps(_mm256_extractf128_ps(acc_min8, 1), _mm256_castps256_ps128(acc_min8));
+            __m128 acc_max = _mm_max_ps(_mm256_extractf128_ps(acc_max8, 1), _mm256_castps256_ps128(acc_max8));
+
+            for (; i + 2 <= n; i += 2) {
+                const __m128 r = rotate_sse2(_mm_loadu_ps(src + 2 * i), cos_v, sin_v, pos_v);
+                _mm_storeu_ps(dst + 2 * i, r);
+                acc_min = _mm_min_ps(r, acc_min);
+                acc_max = _mm_max_ps(r, acc_max);
+            }
+            for (; i < n; ++i) {
+                __m128 r = rotate_sse2(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const f64*>(src + 2 * i))), cos_v, sin_v, pos_v);
+                _mm_store_sd(reinterpret_cast<f64*>(dst + 2 * i), _mm_castps_pd(r));
+                r = _mm_movelh_ps(r, r);
+                acc_min = _mm_min_ps(r, acc_min);
+                acc_max = _mm_max_ps(r, acc_max);
+            }
+
+            store_bbox_sse2(job.bounding_box, acc_min, acc_max);
+            job.rel_vertexes[n] = job.rel_vertexes[0];
+        }
+    }
+#endif
+
+    VertexKernel::Isa detect_isa() {
+#ifdef VTXKERNEL_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return VertexKernel::AVX2;
+        if (__builtin_cpu_supports("sse2"))
+            return VertexKernel::SSE2;
+#endif
+        return VertexKernel::SCALAR;
+    }
+}
+
+VertexKernel::Isa VertexKernel::best_isa() {
+    static const Isa isa = detect_isa();
+    return isa;
+}
+
+bool VertexKernel::is_supported(Isa isa) {
+    return isa <= best_isa();
+}
+
+const char* VertexKernel::isa_name(Isa isa) {
+    switch (isa) {
+    case SCALAR: return "scalar";
+    case SSE2: return "sse2";
+    case AVX2: return "avx2";
+    }
+
+    return "unknown";
+}
+
+void VertexKernel::transform(const Job* jobs, usize count) {
+    transform(jobs, count, best_isa());
+}
+
+void VertexKernel::transform(const Job* jobs, usize count, Isa isa) {
+    switch (isa) {
+#ifdef VTXKERNEL_X86
+    case AVX2:
+        transform_avx2(jobs, count);
+        return;
+    case SSE2:
+        transform_sse2(jobs, count);
+        return;
+#endif
+    default:
+        transform_scalar(jobs, count);
+        return;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#ifndef VTXKERNEL_HPP_
+#define VTXKERNEL_HPP_
+
+#include "typedef.hpp"
+
+/**
+ * @brief Batched vertex transform kernels.
+ *
+ * Rotates and translates the shape vertexes of many entities in a single call, writing the closed world space
+ * outline and computing the bounding box of the new outline in the same pass.
+ *
+ * A scalar implementation is always available. On x86 there are also SSE2 and AVX2 implementations, and the best
+ * one supported by the running CPU is chosen the first time transform() is called. All the implementations do
+ * the same floating point operations in the same order, so the outlines are bit identical to the scalar path.
+ */
+namespace VertexKernel {
+    enum Isa {
+        SCALAR, SSE2, AVX2
+    };
+
+    /**
+     * @brief The transform of a single entity.
+     *
+     * The output outline must have room for vtx_count + 1 vertexes, as the first vertex is repeated at the end to
+     * close the drawn shape. The input vertexes may point to the output outline, to transform in place.
+     */
+    struct Job {
+        const f32_2* vertexes;
+        usize vtx_count;
+        f32_2 position;
+        f32 sin_angle;
+        f32 cos_angle;
+        f32_2* rel_vertexes;
+        f32_2* bounding_box;
+    };
+
+    /**
+     * @brief Get the best implementation supported by the running CPU.
+     */
+    Isa best_isa();
+
+    /**
+     * @brief Check if an implementation can run on this CPU.
+     */
+    bool is_supported(Isa isa);
+
+    const char* isa_name(Isa isa);
+
+    /**
+     * @brief Run all the jobs with the best implementation available.
+     * @param jobs The jobs to run.
+     * @param count The amount of jobs.
+     */
+    void transform(const Job* jobs, usize count);
+
+    /**
+     * @brief Run all the jobs with a specific implementation.
+     * @param jobs The jobs to run.
+     * @param count The amount of jobs.
+     * @param isa The implementation to use, which must be supported.
+     */
+    void transform(const Job* jobs, usize count, Isa isa);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "workerpool.hpp"
+#include "profiler.hpp"
+
+WorkerPool::WorkerPool(usize thread_count)
+    : task(nullptr), task_count(0), next_task(0), busy_workers(0), generation(0), stopping(false) {
+    if (thread_count == 0)
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+    for (usize i = 1; i < thread_count; ++i)
+        threads.emplace_back(&WorkerPool::worker_loop, this);
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    wake.notify_all();
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+void WorkerPool::work() {
+    PROFILE_ZONE("WorkerPool::work");
+
+    for (usize t = next_task.fetch_add(1); t < task_count; t = next_task.fetch_add(1))
+        (*task)(t);
+}
+
+void WorkerPool::worker_loop() {
+    u64 seen = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping or generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+        }
+
+        work();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy_workers == 0)
+            done.notify_one();
+    }
+}
+
+void WorkerPool::run(usize task_count, const std::function<void(usize)>& task) {
+    if (threads.empty() or task_count <= 1) {
+        for (usize t = 0; t < task_count; ++t)
+            task(t);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        this->task_count = task_count;
+        next_task = 0;
+        busy_workers = threads.size();
+        ++generation;
+    }
+
+    wake.notify_all();
+    work();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return busy_workers == 0; });
+    this->task = nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#ifndef WORKERPOOL_HPP_
+#define WORKERPOOL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "typedef.hpp"
+
+/**
+ * @brief Fixed pool of worker threads running batches of indexed tasks.
+ *
+ * A batch is split into tasks by the caller, and the tasks are claimed by the workers (and the calling thread) in
+ * any order. The split itself never depends on the amount of threads, so as long as every task only writes its own
+ * outputs, a batch gives the same result whatever the pool size, which keeps the simulation deterministic.
+ *
+ * A pool of one thread has no workers at all, and runs every batch on the calling thread.
+ *
+ * @warning Tasks must not throw, and must not run batches on the same pool.
+ */
+class WorkerPool {
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(usize)>* task;
+    usize task_count;
+    std::atomic<usize> next_task;
+    usize busy_workers;
+    u64 generation;
+    bool stopping;
+
+    void work();
+    void worker_loop();
+
+public:
+    /**
+     * @brief Start the workers.
+     * @param thread_count The amount of threads running each batch, including the calling one. Zero picks one
+     * thread per hardware thread.
+     */
+    explicit WorkerPool(usize thread_count = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    usize get_thread_count() const { return threads.size() + 1; }
+
+    /**
+     * @brief Run a batch of tasks and wait for all of them to finish.
+     * @param task_count The amount of tasks.
+     * @param task Called once for every task index in [0, task_count).
+     */
+    void run(usize task_count, const std::function<void(usize)>& task);
+
+    /**
+     * @brief Run a loop over [0, count) in chunks of grain indexes.
+     * @param count The amount of indexes.
+     * @param grain The size of each chunk, which should be large enough to amortize waking up the workers.
+     * @param body Called as body(begin, end) once for every chunk.
+     */
+    template <typename F>
+    void parallel_for(usize count, usize grain, const F& body) {
+        const usize chunks = (count + grain - 1) / grain;
+
+        run(chunks, [&](usize chunk) {
+            body(chunk * grain, std::min(count, (chunk + 1) * grain));
+        });
+    }
+
+    /**
+     * @brief Sort a vector by sorting fixed chunks in parallel, then merging them pairwise.
+     * @note The elements should be unique under operator<, or equal ones indistinguishable, for the result to
+     * match a plain std::sort.
+     */
+    template <typename T>
+    void sort(std::vector<T>& values) {
+        static constexpr usize SORT_CHUNKS = 16;
+        static constexpr usize MIN_CHUNK_SIZE = 4096;
+
+        if (values.size() < 2 * MIN_CHUNK_SIZE or threads.empty()) {
+            std::sort(values.begin(), values.end());
+            return;
+        }
+
+        const usize size = values.size();
+        const auto bound = [size](usize chunk) { return chunk * size / SORT_CHUNKS; };
+
+        run(SORT_CHUNKS, [&](usize chunk) {
+            std::sort(values.begin() + bound(chunk), values.begin() + bound(chunk + 1));
+        });
+
+        for (usize width = 1; width < SORT_CHUNKS; width *= 2) {
+            run(SORT_CHUNKS / (2 * width), [&](usize merge) {
+                const usize first = 2 * width * merge;
+                std::inplace_merge(values.begin() + bound(first), values.begin() + bound(first + width), values.begin() + bound(first + 2 * width));
+            });
+        }
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "chunkstreamer.hpp"
+#include "rng.hpp"
+#include "asteroid.hpp"
+#include "placementgrid.hpp"
+#include "profiler.hpp"
+
+ChunkStreamer::ChunkStreamer(u64 seed, usize asteroid_capacity, i32 window)
+    : seed(seed), window(std::max(1, window)), generating_key(0), generating(false), stopping(false) {
+    const usize chunks = static_cast<usize>(this->window) * this->window;
+
+    // Ids stop short of NO_ID, so no chunk gets more than that.
+    asteroid_capacity = std::min<usize>(asteroid_capacity, ChunkAsteroid::NO_ID * chunks);
+    base_count = asteroid_capacity / chunks;
+    extra_count = asteroid_capacity % chunks;
+
+    ShapeLibrary::shared();
+    thread = std::thread(&ChunkStreamer::thread_loop, this);
+}
+
+ChunkStreamer::~ChunkStreamer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    pending_changed.notify_all();
+    thread.join();
+}
+
+std::vector<ChunkAsteroid> ChunkStreamer::generate(u64 seed, ChunkCoord coord, usize asteroid_count) {
+    PROFILE_ZONE("ChunkStreamer::generate");
+
+    const ShapeLibrary& library = ShapeLibrary::shared();
+    Rng rng(seed ^ coord.key(), Rng::CHUNK_STREAM);
+    PlacementGrid grid(ChunkCoord::CHUNK_SIZE, AsteroidShape::max_radius(AsteroidShape::MAX_SCALE));
+    std::vector<ChunkAsteroid> asteroids;
+    asteroids.reserve(asteroid_count);
+    grid.reserve(asteroid_count);
+
+    for (usize i = 0; i < asteroid_count; ++i) {
+        ChunkAsteroid asteroid;
+        asteroid.id = static_cast<u16>(i);
+        asteroid.shape_id = library.get_random_asteroid(rng);
+
+        const f32 radius = library.get_radius(asteroid.shape_id);
+        bool placed = false;
+
+        // Give up on a crowded chunk rather than loop, the asteroid is left out. Keeping the whole asteroid inside of
+        // the chunk means it can't overlap one of a neighbour chunk either.
+        for (usize attempt = 0; !placed and attempt < PLACEMENT_ATTEMPTS; ++attempt) {
+            asteroid.position = { rng.next_f32(radius, ChunkCoord::CHUNK_SIZE - radius), rng.next_f32(radius, ChunkCoord::CHUNK_SIZE - radius) };
+            placed = grid.try_place(asteroid.position, radius);
+        }
+
+        asteroid.velocity = { rng.next_f32() * 2.0f - 1.0f, rng.next_f32() * 2.0f - 1.0f };
+        asteroid.angle = rng.next_f32() * 2.0f * M_PI;
+        asteroid.angular_velocity = rng.next_f32() * 0.1f - 0.05f;
+
+        if (placed)
+            asteroids.push_back(asteroid);
+    }
+
+    return asteroids;
+}
+
+void ChunkStreamer::thread_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    for (;;) {
+        pending_changed.wait(lock, [&] { return stopping or !pending.empty(); });
+        if (stopping)
+            return;
+
+        const ChunkCoord coord = pending.front();
+        pending.pop_front();
+        generating_key = coord.key();
+        generating = true;
+
+        lock.unlock();
+        std::vector<ChunkAsteroid> asteroids = generate(seed, coord, get_asteroid_count(coord));
+        lock.lock();
+
+        ready[coord.key()] = std::move(asteroids);
+        generating = false;
+        ready_changed.notify_all();
+    }
+}
+
+void ChunkStreamer::prefetch(ChunkCoord coord) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (ready.count(coord.key()) or (generating and generating_key == coord.key()))
+            return;
+        if (std::find(pending.begin(), pending.end(), coord) != pending.end())
+            return;
+
+        pending.push_back(coord);
+    }
+
+    pending_changed.notify_one();
+}
+
+void ChunkStreamer::retain(ChunkCoord center, i32 radius) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    pending.erase(std::remove_if(pending.begin(), pending.end(), [&](ChunkCoord coord) {
+        return ChunkCoord::distance(coord, center) > radius;
+    }), pending.end());
+
+    for (auto it = ready.begin(); it != ready.end();) {
+        it = ChunkCoord::distance(ChunkCoord::from_key(it->first), center) > radius ? ready.erase(it) : std::next(it);
+    }
+}
+
+usize ChunkStreamer::take(ChunkCoord coord, std::vector<ChunkAsteroid>& out) {
+    std::vector<ChunkAsteroid> generated;
+    bool found = false;
+
+    {
+        PROFILE_ZONE("ChunkStreamer::take wait");
+        std::unique_lock<std::mutex> lock(mutex);
+
+        const std::deque<ChunkCoord>::iterator queued = std::find(pending.begin(), pending.end(), coord);
+        if (queued != pending.end())
+            pending.erase(queued);
+
+        ready_changed.wait(lock, [&] { return !generating or generating_key != coord.key(); });
+
+        const auto it = ready.find(coord.key());
+        if (it != ready.end()) {
+            generated = std::move(it->second);
+            ready.erase(it);
+            found = true;
+        }
+    }
+
+    if (!found)
+        generated = generate(seed, coord, get_asteroid_count(coord));
+
+    const std::unordered_map<u64, ChunkDiff>::const_iterator found_diff = diffs.find(coord.key());
+    const ChunkDiff* diff = found_diff != diffs.end() ? &found_diff->second : nullptr;
+    const ShapeLibrary& library = ShapeLibrary::shared();
+    const f32_2 origin = coord.origin();
+
+    const auto place = [&](const ChunkAsteroid& asteroid) {
+        out.push_back(asteroid);
+        out.back().position = { origin.x + asteroid.position.x, origin.y + asteroid.position.y };
+    };
+
+    out.clear();
+
+    if (!diff) {
+        for (const ChunkAsteroid& asteroid : generated)
+            place(asteroid);
+        return out.size();
+    }
+
+    // The changed asteroids are kept where they were, even overlapping, as they were like that in the world already.
+    PlacementGrid grid(ChunkCoord::CHUNK_SIZE, AsteroidShape::max_radius(AsteroidShape::MAX_SCALE));
+    grid.reserve(generated.size() + diff->changed.size());
+    for (const ChunkAsteroid& asteroid : diff->changed)
+        grid.place(asteroid.position, library.get_radius(asteroid.shape_id));
+
+    for (const ChunkAsteroid& asteroid : generated)
+        if (!diff->is_removed(asteroid.id) and grid.try_place(asteroid.position, library.get_radius(asteroid.shape_id)))
+            place(asteroid);
+
+    const usize untouched = out.size();
+    for (const ChunkAsteroid& asteroid : diff->changed)
+        place(asteroid);
+
+    return untouched;
+}
+
+void ChunkStreamer::store_diff(ChunkCoord coord, ChunkDiff&& diff) {
+    if (diff.removed.empty() and diff.changed.empty())
+        diffs.erase(coord.key());
+    else
+        diffs[coord.key()] = std::move(diff);
+}
+
+void ChunkStreamer::add_changed(ChunkCoord coord, const ChunkAsteroid& asteroid) {
+    diffs[coord.key()].changed.push_back(asteroid);
+}
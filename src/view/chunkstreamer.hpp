@@ -0,0 +1,191 @@
+#ifndef CHUNKSTREAMER_HPP_
+#define CHUNKSTREAMER_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "typedef.hpp"
+#include "shapelibrary.hpp"
+
+/**
+ * @brief Coordinates of a square chunk of the world, CHUNK_SIZE units wide.
+ */
+struct ChunkCoord {
+    i32 x;
+    i32 y;
+
+    static constexpr f32 CHUNK_SIZE = 8000.0f;
+
+    bool operator==(const ChunkCoord& other) const { return x == other.x and y == other.y; }
+    bool operator!=(const ChunkCoord& other) const { return !(*this == other); }
+
+    u64 key() const { return static_cast<u64>(static_cast<u32>(x)) << 32 | static_cast<u32>(y); }
+    static ChunkCoord from_key(u64 key) { return { static_cast<i32>(key >> 32), static_cast<i32>(key & U32MAX) }; }
+    f32_2 origin() const { return { x * CHUNK_SIZE, y * CHUNK_SIZE }; }
+
+    /**
+     * @brief Get the chunk containing a position.
+     */
+    static ChunkCoord of(f32_2 position) {
+        return { static_cast<i32>(std::floor(position.x / CHUNK_SIZE)), static_cast<i32>(std::floor(position.y / CHUNK_SIZE)) };
+    }
+
+    /**
+     * @brief Get the distance between two chunks, in chunks along the farthest axis.
+     */
+    static i32 distance(ChunkCoord a, ChunkCoord b) { return std::max(std::abs(a.x - b.x), std::abs(a.y - b.y)); }
+};
+
+/**
+ * @brief State of an asteroid of a chunk, with its position relative to the chunk origin.
+ */
+struct ChunkAsteroid {
+    static constexpr u16 NO_ID = U16MAX; // Not one of the generated asteroids, such as a spawned one.
+
+    u16 id; // Index of the asteroid in the generated chunk.
+    ShapeId shape_id;
+    f32_2 position;
+    f32_2 velocity;
+    f32 angle;
+    f32 angular_velocity;
+};
+
+/**
+ * @brief Changes to a chunk since it was generated, kept when a modified chunk is evicted.
+ *
+ * Untouched asteroids are not stored at all, as they can be generated again. Only the removed asteroids, as one bit
+ * per generated id, and the ones whose path was changed or that drifted in from another chunk, with their state when
+ * they were stored, are kept. A changed asteroid is also flagged as removed, so that only its changed state comes
+ * back.
+ */
+struct ChunkDiff {
+    std::vector<u64> removed;
+    std::vector<ChunkAsteroid> changed;
+
+    void remove(u16 id) {
+        if (removed.size() <= id / 64u)
+            removed.resize(id / 64u + 1, 0);
+        removed[id / 64u] |= 1ull << (id % 64u);
+    }
+
+    bool is_removed(u16 id) const { return id / 64u < removed.size() and (removed[id / 64u] >> (id % 64u) & 1); }
+};
+
+/**
+ * @brief Generator and store of world chunks, streamed by a background thread.
+ *
+ * A chunk is generated only from the world seed and its coordinates, so it comes out the same whenever and in
+ * whatever order it is asked for. Chunks are requested ahead with prefetch(), which queues them for the background
+ * thread, and picked up with take(), which waits for a chunk the thread is already working on, or generates it on
+ * the calling thread if it wasn't prefetched. As a result, what the world gets never depends on the timing of the
+ * thread, only the time the caller waits does.
+ *
+ * Generated asteroids are placed without overlaps by dart throwing on a PlacementGrid, entirely inside of their chunk
+ * so they can't overlap those of the neighbours either. A chunk doesn't move while it isn't loaded: take() brings the
+ * untouched asteroids back in their generated layout and the changed ones where their diff left them, so nothing
+ * jumps to where it could overlap another. A generated asteroid overlapped by a changed one is left out instead.
+ *
+ * @note The thread reads the shared ShapeLibrary, which the constructor builds first if needed.
+ */
+class ChunkStreamer {
+public:
+    // Most asteroids a chunk is meant to hold. Dart throwing places this many in practically every chunk, while it
+    // starts leaving asteroids out at about 200, and can't fit many more than 1600 at all.
+    static constexpr usize MAX_CHUNK_ASTEROIDS = 128;
+
+private:
+    static constexpr usize PLACEMENT_ATTEMPTS = 64;
+
+    u64 seed;
+    i32 window;
+    usize base_count;
+    usize extra_count;
+    std::unordered_map<u64, ChunkDiff> diffs;
+
+    std::mutex mutex;
+    std::condition_variable ready_changed;
+    std::condition_variable pending_changed;
+    std::deque<ChunkCoord> pending;
+    std::unordered_map<u64, std::vector<ChunkAsteroid>> ready;
+    u64 generating_key;
+    bool generating;
+    bool stopping;
+    std::thread thread;
+
+    void thread_loop();
+
+public:
+    /**
+     * @param seed The seed of the world.
+     * @param asteroid_capacity The amount of asteroids generated in every window x window square of chunks.
+     * @param window The width in chunks of the square the capacity is shared out over, such as the loaded chunks.
+     */
+    ChunkStreamer(u64 seed, usize asteroid_capacity, i32 window);
+    ~ChunkStreamer();
+
+    ChunkStreamer(const ChunkStreamer&) = delete;
+    ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+    /**
+     * @brief Get the amount of asteroids generated in a chunk.
+     *
+     * Every chunk gets an equal share of the capacity, and the remainder goes one asteroid each to the chunks whose
+     * place in the repeating window x window pattern comes first. Any window x window square holds every place once,
+     * so it always adds up to the whole capacity, wherever it lies.
+     */
+    usize get_asteroid_count(ChunkCoord coord) const {
+        const i32 x = (coord.x % window + window) % window;
+        const i32 y = (coord.y % window + window) % window;
+        return base_count + (static_cast<usize>(y * window + x) < extra_count);
+    }
+
+    usize get_max_asteroid_count() const { return base_count + (extra_count > 0); }
+    usize get_diff_count() const { return diffs.size(); }
+
+    /**
+     * @brief Generate the asteroids of a chunk, as they are at time zero.
+     */
+    static std::vector<ChunkAsteroid> generate(u64 seed, ChunkCoord coord, usize asteroid_count);
+
+    /**
+     * @brief Queue a chunk for the background thread, unless it is already queued or generated.
+     */
+    void prefetch(ChunkCoord coord);
+
+    /**
+     * @brief Drop the queued and generated chunks farther than a distance from a center chunk.
+     */
+    void retain(ChunkCoord center, i32 radius);
+
+    /**
+     * @brief Get the asteroids of a chunk, with its diff applied.
+     * @param coord The chunk.
+     * @param out Set to the asteroids, with positions in world space.
+     * @return The amount of asteroids that come untouched from the generator, which are the first ones in out.
+     */
+    usize take(ChunkCoord coord, std::vector<ChunkAsteroid>& out);
+
+    /**
+     * @brief Keep the changes to an evicted chunk, replacing its previous diff.
+     * @param coord The chunk.
+     * @param diff The changes, with positions relative to the chunk origin. An empty one drops the previous diff.
+     */
+    void store_diff(ChunkCoord coord, ChunkDiff&& diff);
+
+    /**
+     * @brief Add a changed asteroid to the diff of a chunk that isn't loaded, such as one it drifted into.
+     * @param coord The chunk.
+     * @param asteroid The asteroid, with its position relative to the chunk origin.
+     */
+    void add_changed(ChunkCoord coord, const ChunkAsteroid& asteroid);
+};
+
+#endif
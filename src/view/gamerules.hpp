@@ -0,0 +1,46 @@
+#ifndef GAMERULES_HPP_
+#define GAMERULES_HPP_
+
+#include "typedef.hpp"
+#include "world.hpp"
+#include "rover.hpp"
+#include "smoothcam.hpp"
+
+/**
+ * @brief The rules of a game session around the World, for a single simulation tick.
+ *
+ * Both the game and the headless runner step through here, so that a session replayed by one plays out exactly like
+ * it did in the other.
+ */
+struct GameRules {
+    static constexpr usize MOONCOIN_SPAWN_TICKS = 45;
+    static constexpr f32 MOONCOIN_SPAWN_RANGE = 4000.0f;
+    static constexpr f32 HEALTH_DRAIN = 0.15f;
+
+    /**
+     * @brief Apply the input, step the world and the camera, drain health and spawn new mooncoins.
+     * @param world The world to step.
+     * @param cam The camera following the rover, which also moves the world culling area.
+     * @param input The controls held during this tick.
+     * @param tick The number of this tick since the start of the session.
+     * @param viewport The size of the view, to center the camera on the rover.
+     */
+    static void tick(World& world, SmoothCamera& cam, const RoverInput& input, u64 tick, f32_2 viewport) {
+        const f32_2 rover_pos = world.get_rover().get_position();
+        const f32_2 centered_view_of_rover = { rover_pos.x - viewport.x / 2, rover_pos.y - viewport.y / 2 };
+
+        world.get_rover().apply_input(input, 1.0f);
+
+        cam.target(centered_view_of_rover);
+        world.step(1.0f);
+        cam.step(1.0f);
+        world.set_position(cam.get());
+
+        world.get_rover().add_health(-HEALTH_DRAIN);
+
+        if (tick % MOONCOIN_SPAWN_TICKS == MOONCOIN_SPAWN_TICKS - 1)
+            world.spawn_mooncoin_nearby(centered_view_of_rover, MOONCOIN_SPAWN_RANGE);
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,82 @@
+#ifndef LINEBATCH_HPP_
+#define LINEBATCH_HPP_
+
+#include <vector>
+#include <raylib.h>
+
+#include "typedef.hpp"
+
+/**
+ * @brief CPU side builder of line geometry, grouping the segments of many line strips by color.
+ *
+ * Each color gets a layer, holding its segments as pairs of vertexes in one contiguous buffer, so that a whole layer
+ * can be submitted with a single draw. The builder never calls into raylib, it only gathers vertexes, so that it can
+ * be filled and inspected without a window.
+ *
+ * Layers and their buffers are kept across clear(), so that after the first frames building a batch does not
+ * allocate anymore.
+ */
+class LineBatch {
+public:
+    struct Layer {
+        Color color;
+        std::vector<f32_2> vertexes;
+    };
+
+private:
+    std::vector<Layer> layers;
+
+    Layer& layer_of(Color color) {
+        for (Layer& layer : layers)
+            if (layer.color.r == color.r and layer.color.g == color.g and layer.color.b == color.b and layer.color.a == color.a)
+                return layer;
+
+        layers.push_back({ color, {} });
+        return layers.back();
+    }
+
+public:
+    /**
+     * @brief Empty every layer, keeping the layers and their buffers.
+     */
+    void clear() {
+        for (Layer& layer : layers)
+            layer.vertexes.clear();
+    }
+
+    /**
+     * @brief Add the segments of a line strip.
+     * @param vertexes The vertexes of the strip.
+     * @param vtx_count The amount of vertexes, a strip of n vertexes adds n - 1 segments.
+     * @param color The color of the strip.
+     */
+    void add_strip(const f32_2* vertexes, usize vtx_count, Color color) {
+        if (vtx_count < 2)
+            return;
+
+        std::vector<f32_2>& out = layer_of(color).vertexes;
+        const usize first = out.size();
+        out.resize(first + 2 * (vtx_count - 1));
+
+        f32_2* segment = out.data() + first;
+        for (usize i = 0; i + 1 < vtx_count; ++i) {
+            segment[2 * i] = vertexes[i];
+            segment[2 * i + 1] = vertexes[i + 1];
+        }
+    }
+
+    usize get_layer_count() const { return layers.size(); }
+    const Layer& get_layer(usize i) const { return layers[i]; }
+
+    /**
+     * @brief Get the amount of segment vertexes in all the layers, two per segment.
+     */
+    usize get_vertex_count() const {
+        usize count = 0;
+        for (const Layer& layer : layers)
+            count += layer.vertexes.size();
+        return count;
+    }
+};
+
+#endif
\ No newline at end of file
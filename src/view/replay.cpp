@@ -0,0 +1,102 @@
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "replay.hpp"
+
+static void write_u16(std::ofstream& out, u16 value) {
+    const char bytes[2] = { static_cast<char>(value & 0xff), static_cast<char>(value >> 8) };
+    out.write(bytes, sizeof(bytes));
+}
+
+static void write_u32(std::ofstream& out, u32 value) {
+    write_u16(out, static_cast<u16>(value & 0xffff));
+    write_u16(out, static_cast<u16>(value >> 16));
+}
+
+static void write_f32(std::ofstream& out, f32 value) {
+    u32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    write_u32(out, bits);
+}
+
+static u16 read_u16(std::ifstream& in) {
+    unsigned char bytes[2] = { 0, 0 };
+    in.read(reinterpret_cast<char*>(bytes), sizeof(bytes));
+    return static_cast<u16>(bytes[0] | (bytes[1] << 8));
+}
+
+static u32 read_u32(std::ifstream& in) {
+    const u32 low = read_u16(in);
+    return low | static_cast<u32>(read_u16(in)) << 16;
+}
+
+static f32 read_f32(std::ifstream& in) {
+    const u32 bits = read_u32(in);
+    f32 value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+Replay Replay::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        throw std::runtime_error("Replay::load cannot open file \"" + path + "\".");
+
+    if (read_u32(in) != MAGIC)
+        throw std::runtime_error("Replay::load cannot read file \"" + path + "\": not a replay.");
+    if (read_u32(in) != VERSION)
+        throw std::runtime_error("Replay::load cannot read file \"" + path + "\": unsupported version.");
+
+    Settings settings;
+    settings.seed = read_u32(in);
+    settings.asteroid_count = read_u32(in);
+    settings.mooncoin_count = read_u32(in);
+    settings.viewport_w = read_f32(in);
+    settings.viewport_h = read_f32(in);
+    settings.broadphase_cell_size = read_f32(in);
+
+    Replay replay(settings);
+    const u32 tick_count = read_u32(in);
+    replay.inputs.reserve(tick_count);
+
+    while (in and replay.inputs.size() < tick_count) {
+        const u8 keys = static_cast<u8>(in.get());
+        const u16 run = read_u16(in);
+        replay.inputs.insert(replay.inputs.end(), run, keys);
+    }
+
+    if (!in or replay.inputs.size() != tick_count)
+        throw std::runtime_error("Replay::load cannot read file \"" + path + "\": truncated or corrupt inputs.");
+
+    return replay;
+}
+
+void Replay::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+        throw std::runtime_error("Replay::save cannot open file \"" + path + "\".");
+
+    write_u32(out, MAGIC);
+    write_u32(out, VERSION);
+    write_u32(out, settings.seed);
+    write_u32(out, settings.asteroid_count);
+    write_u32(out, settings.mooncoin_count);
+    write_f32(out, settings.viewport_w);
+    write_f32(out, settings.viewport_h);
+    write_f32(out, settings.broadphase_cell_size);
+    write_u32(out, static_cast<u32>(inputs.size()));
+
+    for (usize begin = 0; begin < inputs.size();) {
+        usize end = begin + 1;
+        while (end < inputs.size() and inputs[end] == inputs[begin] and end - begin < U16MAX)
+            ++end;
+
+        out.put(static_cast<char>(inputs[begin]));
+        write_u16(out, static_cast<u16>(end - begin));
+        begin = end;
+    }
+
+    if (!out)
+        throw std::runtime_error("Replay::save cannot write file \"" + path + "\".");
+}
\ No newline at end of file
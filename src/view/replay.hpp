@@ -0,0 +1,77 @@
+#ifndef REPLAY_HPP_
+#define REPLAY_HPP_
+
+#include <string>
+#include <vector>
+
+#include "typedef.hpp"
+#include "rover.hpp"
+
+/**
+ * @brief Recording of a game session, enough to play it again exactly.
+ *
+ * A session is decided by the random seed, the few settings that change the simulation, and the controls held at
+ * every tick, as spawning follows the tick count and not the wall clock. The controls are kept as one byte per tick
+ * while recording, and written to disk as runs of equal bytes, since they rarely change from one tick to the next.
+ *
+ * The file is little endian: a header with the magic "EARP", the version, the settings and the amount of ticks,
+ * followed by runs of a control byte and a 16 bit run length.
+ */
+class Replay {
+public:
+    struct Settings {
+        u32 seed;
+        u32 asteroid_count;
+        u32 mooncoin_count;
+        f32 viewport_w;
+        f32 viewport_h;
+        f32 broadphase_cell_size; // Zero for the World default.
+    };
+
+private:
+    static constexpr u32 MAGIC = 0x50524145; // "EARP"
+    static constexpr u32 VERSION = 4; // 4: asteroids come from the chunks of the world.
+    static constexpr u8 KEY_FORWARD = 1 << 0;
+    static constexpr u8 KEY_LEFT = 1 << 1;
+    static constexpr u8 KEY_RIGHT = 1 << 2;
+
+    Settings settings;
+    std::vector<u8> inputs;
+
+public:
+    explicit Replay(const Settings& settings) : settings(settings) {}
+
+    /**
+     * @brief Read a replay file.
+     * @param path The file written by save().
+     * @return The replay.
+     */
+    static Replay load(const std::string& path);
+
+    /**
+     * @brief Write the replay to a file.
+     * @param path The file to write.
+     */
+    void save(const std::string& path) const;
+
+    const Settings& get_settings() const { return settings; }
+    usize get_tick_count() const { return inputs.size(); }
+
+    /**
+     * @brief Add the controls of the next tick.
+     */
+    void record(const RoverInput& input) {
+        inputs.push_back((input.forward ? KEY_FORWARD : 0) | (input.left ? KEY_LEFT : 0) | (input.right ? KEY_RIGHT : 0));
+    }
+
+    /**
+     * @brief Get the controls held at a tick.
+     * @param tick The tick, less than get_tick_count().
+     */
+    RoverInput get_input(usize tick) const {
+        const u8 keys = inputs[tick];
+        return { (keys & KEY_FORWARD) != 0, (keys & KEY_LEFT) != 0, (keys & KEY_RIGHT) != 0 };
+    }
+};
+
+#endif
\ No newline at end of file
@@ -10,16 +10,23 @@ private:
     const f32 MAX_SPEED;
     const f32 DIST_SCALE;
     f32_2 current_pos;
+    f32_2 previous_pos;
     f32_2 target_pos;
 
 public:
-    SmoothCamera(f32_2 pos) : OK_DIST(0.05f), MAX_SPEED(0.5f), DIST_SCALE(0.06f), current_pos(pos), target_pos(pos) {}
+    SmoothCamera(f32_2 pos) : OK_DIST(0.05f), MAX_SPEED(0.5f), DIST_SCALE(0.06f), current_pos(pos), previous_pos(pos), target_pos(pos) {}
 
     inline f32_2 get() const { return current_pos; }
-    inline void set(f32_2 pos) { current_pos = pos; target_pos = pos; }
+    inline f32_2 get_interpolated(f32 alpha) const {
+        return { previous_pos.x + (current_pos.x - previous_pos.x) * alpha, previous_pos.y + (current_pos.y - previous_pos.y) * alpha };
+    }
+
+    inline void set(f32_2 pos) { current_pos = pos; previous_pos = pos; target_pos = pos; }
     inline void target(f32_2 pos) { target_pos = pos; }
 
     inline void step(f32 scale) { 
+        previous_pos = current_pos;
+
         const f32_2 diff = { target_pos.x - current_pos.x, target_pos.y - current_pos.y };
         f32 dist2 = diff.x * diff.x + diff.y * diff.y;
 
@@ -31,4 +38,4 @@ public:
     }
 };
 
-#endif
+#endif
\ No newline at end of file
@@ -0,0 +1,122 @@
+#ifndef SOUNDBANK_HPP_
+#define SOUNDBANK_HPP_
+
+#include <string>
+#include <vector>
+#include <raylib.h>
+
+#include "typedef.hpp"
+#include "profiler.hpp"
+
+/**
+ * @brief Sound effects decoded once, and played through a fixed pool of voices each.
+ *
+ * Every effect keeps its decoded samples in a single Sound, and its voices are aliases of it, which share the samples
+ * and only add their own playback state. Playing an effect picks an idle voice, or restarts the one that started
+ * longest ago, so the amount of voices playing at once (and the work of the audio thread) never grows past the pool.
+ *
+ * An effect can also have a cooldown, during which playing it again does nothing, to keep an event firing every tick
+ * from restarting its sound over and over.
+ *
+ * @warning Effects must be added after InitAudioDevice(), and unloaded before CloseAudioDevice().
+ */
+class SoundBank {
+public:
+    typedef usize Effect;
+
+private:
+    struct Entry {
+        Sound sound;
+        usize first_voice;
+        usize voice_count;
+        f64 cooldown;
+        f64 last_played;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<Sound> voices;
+    std::vector<f64> voice_started;
+    f64 now;
+
+public:
+    SoundBank() : now(0.0) {}
+    ~SoundBank() { unload(); }
+
+    SoundBank(const SoundBank&) = delete;
+    SoundBank& operator=(const SoundBank&) = delete;
+
+    /**
+     * @brief Decode a sound file and create its voices.
+     * @param path The sound file.
+     * @param voice_count The most times the effect can play at once.
+     * @param cooldown The least time between two plays of the effect, in seconds.
+     * @param volume The volume of every voice.
+     * @return The effect to play. If the file cannot be loaded the effect has no voices, and playing it does nothing.
+     */
+    Effect add(const std::string& path, usize voice_count, f64 cooldown = 0.0, f32 volume = 1.0f) {
+        Entry entry = { LoadSound(path.c_str()), voices.size(), 0, cooldown, -cooldown };
+
+        if (entry.sound.frameCount > 0) {
+            for (usize i = 0; i < voice_count; ++i) {
+                Sound voice = LoadSoundAlias(entry.sound);
+                SetSoundVolume(voice, volume);
+                voices.push_back(voice);
+                voice_started.push_back(0.0);
+            }
+            entry.voice_count = voice_count;
+        }
+
+        entries.push_back(entry);
+        return entries.size() - 1;
+    }
+
+    /**
+     * @brief Set the time the next plays happen at, usually once per frame.
+     * @param seconds A clock in seconds, which should never go back.
+     */
+    void set_time(f64 seconds) { now = seconds; }
+
+    /**
+     * @brief Play an effect, unless it is cooling down.
+     * @param effect The effect returned by add().
+     */
+    void play(Effect effect) {
+        PROFILE_ZONE("SoundBank::play");
+
+        Entry& entry = entries[effect];
+
+        if (entry.voice_count == 0 or now - entry.last_played < entry.cooldown)
+            return;
+
+        usize chosen = entry.first_voice;
+        for (usize i = entry.first_voice; i < entry.first_voice + entry.voice_count; ++i) {
+            if (!IsSoundPlaying(voices[i])) {
+                chosen = i;
+                break;
+            }
+            if (voice_started[i] < voice_started[chosen])
+                chosen = i;
+        }
+
+        StopSound(voices[chosen]);
+        PlaySound(voices[chosen]);
+        voice_started[chosen] = now;
+        entry.last_played = now;
+    }
+
+    /**
+     * @brief Stop and free every effect, which is also done on destruction.
+     */
+    void unload() {
+        for (Sound& voice : voices)
+            UnloadSoundAlias(voice);
+        for (Entry& entry : entries)
+            UnloadSound(entry.sound);
+
+        voices.clear();
+        voice_started.clear();
+        entries.clear();
+    }
+};
+
+#endif
\ No newline at end of file
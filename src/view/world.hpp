@@ -1,13 +1,22 @@
 #ifndef WORLD_HPP_
 #define WORLD_HPP_
 
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "typedef.hpp"
 #include "asteroid.hpp"
+#include "asteroidstore.hpp"
 #include "rover.hpp"
 #include "mooncoin.hpp"
 #include "ltmath.hpp"
+#include "rng.hpp"
+#include "entitypool.hpp"
+#include "chunkstreamer.hpp"
+#include "spatialgrid.hpp"
+#include "workerpool.hpp"
+#include "profiler.hpp"
 
 using namespace LookupTableMath;
 
@@ -15,34 +24,74 @@ using namespace LookupTableMath;
  * @brief Main handler for the game world.
  *
  * The World class is responsible for handling all the game's entities and their interactions.
- * It has a circular buffer of asteroids that can be spawned and moved around. By using a circular buffer,
- * the game can start immediately with a set amount of asteroids, and then keep reusing them as they are
- * respawned by the game logic. Also, when coming into view of a hidden asteroid, it will be unculled
- * and start acting normally, creating a more explorable world (perhaps).
+ * Asteroids and mooncoins live in storage of a fixed capacity, chosen when the world is built, and an EntityPool
+ * for each keeps the live ones packed at the front, so stepping never skips holes. By default spawning recycles the
+ * oldest entity once the pool is full, so the game keeps reusing its entities as they are respawned like it would
+ * with a ring buffer. Also, when coming into view of a hidden asteroid, it will be unculled and start acting
+ * normally, creating a more explorable world (perhaps).
  *
- * By changing the type of asteroids, you could technically store everything on the stack.
+ * The asteroids come from chunks of the world, streamed by a ChunkStreamer: the chunks within a radius of the
+ * chunk at the center of the view are loaded, and the rest are evicted, keeping a diff of the asteroids that were
+ * destroyed or changed by a collision. An asteroid belongs to the chunk it is in when chunks are swapped, so one that
+ * drifted across a border is kept by the chunk it drifted into, as a changed asteroid. The asteroid capacity is
+ * shared out between the chunks so that the loaded ones always generate all of it, even with fewer asteroids than
+ * chunks, and the world is endless but never holds more asteroids than that. The radius grows with the capacity, so
+ * that no chunk gets more than ChunkStreamer::MAX_CHUNK_ASTEROIDS and all of them fit. Chunks are swapped right as
+ * the view crosses into another chunk, at the start of a step, and the ring around the loaded chunks is generated
+ * ahead by the streamer thread.
  *
- * @note The game logic is supposed to spawn (reuse) more asteroids, otherwise during the game cycle, all asteroids
- * will eventually move out of view and never come back.
+ * Asteroids are simulated at a level of detail picked by their distance from the view: within CULLING_MARGIN they
+ * collide, within MID_MARGIN they only keep moving, and further away they are frozen until they come back, when
+ * they jump ahead by the time they spent frozen. So the world keeps drifting everywhere, but only the few asteroids
+ * around the view cost the full physics.
+ *
+ * Spawning returns an EntityHandle, which keeps finding the same entity as others are destroyed and the storage is
+ * compacted, and stops resolving once the entity itself is destroyed or recycled.
+ *
+ * Stepping runs in phases spread over a WorkerPool: culling, broadphase, narrowphase and integration each work on
+ * independent slices of the asteroids or of the broadphase pairs. Contacts are only gathered while testing, and
+ * applied afterwards in pair order, so the outcome of a step doesn't depend on the amount of threads.
+ *
+ * Everything random in the world (placement, spawns and shape picks) is drawn from its own generator, on the world
+ * stream of the seed it was built with, or from the chunks of that seed, so the same seed and inputs always play out
+ * the same.
+ *
+ * @note With the REFUSE policy, a full world spawns nothing.
  */
 class World {
+public:
+    static constexpr usize DEFAULT_ASTEROID_CAPACITY = 864;
+    static constexpr usize DEFAULT_MOONCOIN_CAPACITY = 64;
+    static constexpr f32 TICK_RATE = 60.0f; // Simulation ticks per second, for steps with a dt_scale of 1.
+
 private:
-    static constexpr usize CIRCULAR_BUFFER_ASTEROIDS = 864;
-    static constexpr usize CIRCULAR_BUFFER_MOONCOINS = 64;
     static constexpr f32 COLLISION_PUSHBACK = 0.015f;
     static constexpr f32 COLLISION_PUSHBACK_ROVER_V = -2.0f;
     static constexpr f32 CULLING_MARGIN = 1600.0f;
+    static constexpr f32 MID_MARGIN = 8000.0f; // Past this, asteroids are frozen until they come back.
+    static constexpr f32 RENDER_MARGIN = 16.0f; // Covers how far an entity is drawn from its bounds by interpolation.
     static constexpr f32 RANDOMIZER_RANGE = 50000.0f;
+    static constexpr i32 MIN_CHUNK_RADIUS = 2; // Chunks loaded on each side of the center one, at least.
+    static constexpr f32 DEFAULT_BROADPHASE_CELL_SIZE = 2.0f * AsteroidShape::max_radius(AsteroidShape::MAX_SCALE);
+    static constexpr usize ASTEROID_GRAIN = 1024;
+    static constexpr usize PAIR_GRAIN = 512;
 
-    struct AsteroidCull {
-        Asteroid el;
-        bool out_of_view = false;
-    };
-
-    std::vector<AsteroidCull> asteroids;
+    AsteroidStore asteroids;
     std::vector<Mooncoin> mooncoins;
-    usize circular_index_asteroids = 0;
-    usize circular_index_mooncoins = 0;
+    EntityPool asteroid_pool;
+    EntityPool mooncoin_pool;
+
+    // Chunk every asteroid belongs to, its id in the chunk and whether its path changed, moved with the storage.
+    std::vector<u64> asteroid_chunks;
+    std::vector<u16> asteroid_chunk_ids;
+    std::vector<u8> asteroid_touched;
+
+    std::unique_ptr<ChunkStreamer> chunks;
+    i32 chunk_radius; // Chunks loaded on each side of the center one.
+    std::vector<ChunkCoord> loaded_chunks;
+    ChunkCoord center_chunk;
+    std::vector<ChunkAsteroid> chunk_asteroids;
+
     f32_2 position;
     f32_2 culling_viewport;
 
@@ -50,20 +99,219 @@ private:
 
     Rover rover;
 
+    SpatialGrid broadphase;
+    std::unique_ptr<WorkerPool> workers;
+
+    std::vector<u8> pair_candidates;
+    std::vector<u8> pair_contacts;
+    std::vector<f32_2> pair_pushbacks;
+    std::vector<u8> rover_candidates;
+    std::vector<u8> rover_contacts;
+    std::vector<u8> outline_needed;
+    std::vector<usize> visible_asteroids;
+    std::vector<usize> visible_mooncoins;
+
     void (*on_mooncoin_collect)();
     void (*on_asteroid_collision)();
 
-    void next_index_asteroids() { circular_index_asteroids = (circular_index_asteroids + 1) % CIRCULAR_BUFFER_ASTEROIDS; }
-    void next_index_mooncoins() { circular_index_mooncoins = (circular_index_mooncoins + 1) % CIRCULAR_BUFFER_MOONCOINS; }
+    Rng rng;
 
-public:
-    World(f32_2 position, f32_2 culling_viewport, void (*on_mooncoin_collect)() = nullptr, void (*on_asteroid_collision)() = nullptr)
-        : position(position), culling_viewport(culling_viewport), collected_mooncoins(0), on_mooncoin_collect(on_mooncoin_collect), on_asteroid_collision(on_asteroid_collision) {
-        asteroids.resize(CIRCULAR_BUFFER_ASTEROIDS);
-        mooncoins.resize(CIRCULAR_BUFFER_MOONCOINS);
+    void spawn_asteroid(usize index, f32_2 position) {
+        asteroids.get(index).set_position(position);
+        asteroids.get(index).set_angular_velocity(rng.next_f32() * 0.1f - 0.05f);
+        asteroids.get(index).set_velocity({ rng.next_f32() * 2.0f - 1.0f, rng.next_f32() * 2.0f - 1.0f });
 
-        for (usize i = 0; i < get_asteroid_count(); ++i)
-            randomize_asteroid(i);
+        // Kept by the chunk it spawned in as a changed asteroid, even if that chunk isn't loaded.
+        asteroid_chunks[index] = ChunkCoord::of(position).key();
+        asteroid_chunk_ids[index] = ChunkAsteroid::NO_ID;
+        asteroid_touched[index] = 1;
+    }
+
+    /**
+     * @brief Hand the asteroids that drifted out of their chunk over to the chunk they are in now.
+     *
+     * Such an asteroid is no longer where its generated id would put it, so it becomes a changed one of its new chunk,
+     * and its old chunk finds the id missing when it is evicted.
+     */
+    void reassign_chunks() {
+        for (usize i = 0; i < get_asteroid_count(); ++i) {
+            const u64 chunk = ChunkCoord::of(asteroids.get(i).get_position()).key();
+            if (chunk == asteroid_chunks[i])
+                continue;
+
+            asteroid_chunks[i] = chunk;
+            asteroid_chunk_ids[i] = ChunkAsteroid::NO_ID;
+            asteroid_touched[i] = 1;
+        }
+    }
+
+    /**
+     * @brief Remove the asteroids of the chunks that are too far from the center one, keeping their diffs.
+     *
+     * Asteroids in a chunk that isn't loaded at all, having drifted past the loaded ones, are added to the diff of
+     * that chunk.
+     */
+    void evict_chunks() {
+        std::unordered_map<u64, ChunkDiff> diffs;
+        std::unordered_map<u64, std::vector<u8>> live_ids;
+
+        for (usize i = loaded_chunks.size(); i-- > 0;) {
+            if (ChunkCoord::distance(loaded_chunks[i], center_chunk) <= chunk_radius)
+                continue;
+
+            diffs.emplace(loaded_chunks[i].key(), ChunkDiff());
+            live_ids[loaded_chunks[i].key()].assign(chunks->get_max_asteroid_count(), 0);
+            loaded_chunks.erase(loaded_chunks.begin() + i);
+        }
+
+        // Backwards, so that the asteroid moved into a destroyed one's index was already visited.
+        for (usize i = get_asteroid_count(); i-- > 0;) {
+            const std::unordered_map<u64, ChunkDiff>::iterator diff = diffs.find(asteroid_chunks[i]);
+            if (diff == diffs.end()) {
+                const ChunkCoord chunk = ChunkCoord::from_key(asteroid_chunks[i]);
+                if (std::find(loaded_chunks.begin(), loaded_chunks.end(), chunk) != loaded_chunks.end())
+                    continue;
+
+                // Only reassigned or spawned asteroids end up here, which are all changed ones without an id.
+                const AsteroidStore::Ref asteroid = asteroids.get(i);
+                const f32_2 origin = chunk.origin();
+                const f32_2 pos = asteroid.get_position();
+
+                chunks->add_changed(chunk, {
+                    ChunkAsteroid::NO_ID, asteroid.get_shape_id(), { pos.x - origin.x, pos.y - origin.y },
+                    asteroid.get_velocity(), asteroid.get_angle(), asteroid.get_angular_velocity()
+                });
+                destroy_asteroid(asteroid_pool.handle_of(i));
+                continue;
+            }
+
+            const u16 id = asteroid_chunk_ids[i];
+            if (id != ChunkAsteroid::NO_ID)
+                live_ids[diff->first][id] = 1;
+
+            if (asteroid_touched[i]) {
+                const AsteroidStore::Ref asteroid = asteroids.get(i);
+                const f32_2 origin = ChunkCoord::from_key(diff->first).origin();
+                const f32_2 pos = asteroid.get_position();
+
+                diff->second.changed.push_back({
+                    id, asteroid.get_shape_id(), { pos.x - origin.x, pos.y - origin.y }, asteroid.get_velocity(),
+                    asteroid.get_angle(), asteroid.get_angular_velocity()
+                });
+                if (id != ChunkAsteroid::NO_ID)
+                    diff->second.remove(id);
+            }
+
+            destroy_asteroid(asteroid_pool.handle_of(i));
+        }
+
+        for (std::pair<const u64, ChunkDiff>& diff : diffs) {
+            const std::vector<u8>& live = live_ids[diff.first];
+            for (usize id = 0; id < live.size(); ++id)
+                if (!live[id])
+                    diff.second.remove(static_cast<u16>(id));
+
+            chunks->store_diff(ChunkCoord::from_key(diff.first), std::move(diff.second));
+        }
+    }
+
+    /**
+     * @brief Add the asteroids of the chunks around the center one that aren't loaded yet, in a fixed order.
+     */
+    void load_chunks() {
+        for (i32 y = center_chunk.y - chunk_radius; y <= center_chunk.y + chunk_radius; ++y) {
+            for (i32 x = center_chunk.x - chunk_radius; x <= center_chunk.x + chunk_radius; ++x) {
+                const ChunkCoord chunk = { x, y };
+                if (std::find(loaded_chunks.begin(), loaded_chunks.end(), chunk) != loaded_chunks.end())
+                    continue;
+
+                const usize untouched = chunks->take(chunk, chunk_asteroids);
+                loaded_chunks.push_back(chunk);
+
+                for (usize i = 0; i < chunk_asteroids.size(); ++i) {
+                    const ChunkAsteroid& loaded = chunk_asteroids[i];
+                    usize index;
+
+                    asteroid_pool.allocate(index);
+                    if (index == EntityPool::NO_INDEX)
+                        break;
+
+                    asteroids.set_shape(index, loaded.shape_id);
+                    asteroids.get(index).set_position(loaded.position);
+                    asteroids.get(index).set_velocity(loaded.velocity);
+                    asteroids.get(index).set_angle(loaded.angle);
+                    asteroids.get(index).set_angular_velocity(loaded.angular_velocity);
+
+                    asteroid_chunks[index] = chunk.key();
+                    asteroid_chunk_ids[index] = loaded.id;
+                    asteroid_touched[index] = i >= untouched;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Swap the loaded chunks if the view moved into another chunk, and prefetch the ring around them.
+     */
+    void update_chunks() {
+        const ChunkCoord center = ChunkCoord::of({ position.x + culling_viewport.x / 2, position.y + culling_viewport.y / 2 });
+        if (!loaded_chunks.empty() and center == center_chunk)
+            return;
+
+        PROFILE_ZONE("World::update_chunks");
+
+        center_chunk = center;
+        reassign_chunks();
+        evict_chunks();
+        load_chunks();
+
+        chunks->retain(center_chunk, chunk_radius + 1);
+        for (i32 y = center_chunk.y - chunk_radius - 1; y <= center_chunk.y + chunk_radius + 1; ++y)
+            for (i32 x = center_chunk.x - chunk_radius - 1; x <= center_chunk.x + chunk_radius + 1; ++x)
+                if (ChunkCoord::distance({ x, y }, center_chunk) > chunk_radius)
+                    chunks->prefetch({ x, y });
+    }
+
+    void spawn_mooncoin(usize index, f32_2 position) {
+        mooncoins[index].set_position(position);
+        mooncoins[index].set_angular_velocity(rng.next_f32() * 0.6f - 0.3f);
+        mooncoins[index].set_velocity({ rng.next_f32() * 8.0f - 4.0f, rng.next_f32() * 8.0f - 4.0f });
+    }
+
+    f32_2 random_point_around(f32_2 position, f32 range) {
+        const f32 angle = rng.next_f32() * 2.0f * M_PI;
+        f32 sin_angle, cos_angle;
+
+        ltsincosf_q(angle, sin_angle, cos_angle);
+        return { position.x + range * cos_angle, position.y + range * sin_angle };
+    }
+
+public:
+    /**
+     * @param asteroid_capacity The most asteroids alive at once, shared out between the loaded chunks.
+     * @param seed The seed of the world stream and of the chunks, which decides everything random in the world.
+     * @param mooncoin_capacity The most mooncoins alive at once, all spawned when the world is built.
+     */
+    World(f32_2 position, f32_2 culling_viewport, void (*on_mooncoin_collect)() = nullptr, void (*on_asteroid_collision)() = nullptr, usize asteroid_capacity = DEFAULT_ASTEROID_CAPACITY, u64 seed = Rng::DEFAULT_SEED, usize mooncoin_capacity = DEFAULT_MOONCOIN_CAPACITY)
+        : asteroid_pool(asteroid_capacity), mooncoin_pool(mooncoin_capacity), position(position), culling_viewport(culling_viewport), collected_mooncoins(0), broadphase(DEFAULT_BROADPHASE_CELL_SIZE), workers(new WorkerPool()), on_mooncoin_collect(on_mooncoin_collect), on_asteroid_collision(on_asteroid_collision), rng(seed, Rng::WORLD_STREAM) {
+        asteroids.resize(asteroid_capacity, rng);
+        asteroid_chunks.resize(asteroid_capacity);
+        asteroid_chunk_ids.resize(asteroid_capacity);
+        asteroid_touched.resize(asteroid_capacity);
+        mooncoins.resize(mooncoin_capacity);
+
+        // A chunk only fits so many asteroids, so a larger capacity is spread over more loaded chunks.
+        chunk_radius = MIN_CHUNK_RADIUS;
+        while (static_cast<usize>(2 * chunk_radius + 1) * (2 * chunk_radius + 1) * ChunkStreamer::MAX_CHUNK_ASTEROIDS < asteroid_capacity)
+            ++chunk_radius;
+
+        chunks.reset(new ChunkStreamer(seed, asteroid_capacity, 2 * chunk_radius + 1));
+        update_chunks();
+
+        // Everything is allocated before placing, so the oldest mooncoins are the first indexes, like a ring buffer.
+        usize index;
+        while (!mooncoin_pool.is_full())
+            mooncoin_pool.allocate(index);
 
         for (usize i = 0; i < get_mooncoin_count(); ++i)
             randomize_mooncoin(i);
@@ -77,178 +325,346 @@ public:
 
     usize get_collected_mooncoins() const { return collected_mooncoins; }
 
-    void spawn_asteroid_nearby(f32_2 position, f32 range) {
-        const f32 angle = util::randf() * 2.0f * M_PI;
+    f32 get_broadphase_cell_size() const { return broadphase.get_cell_size(); }
+    void set_broadphase_cell_size(f32 cell_size) { broadphase.set_cell_size(cell_size); }
 
-        asteroids[circular_index_asteroids].el.set_position({ position.x + range * ltcosf_q(angle), position.y + range * ltsinf_q(angle) });
-        asteroids[circular_index_asteroids].el.set_angular_velocity(util::randf() * 0.1f - 0.05f);
-        asteroids[circular_index_asteroids].el.set_velocity({ util::randf() * 2.0f - 1.0f, util::randf() * 2.0f - 1.0f });
+    usize get_thread_count() const { return workers->get_thread_count(); }
 
-        next_index_asteroids();
-    }
+    /**
+     * @brief Replace the worker pool used by step().
+     * @param thread_count The amount of threads, including the calling one. Zero picks one per hardware thread.
+     */
+    void set_thread_count(usize thread_count) { workers.reset(new WorkerPool(thread_count)); }
 
-    void spawn_asteroid_at(f32_2 position) {
-        asteroids[circular_index_asteroids].el.set_position(position);
-        asteroids[circular_index_asteroids].el.set_angular_velocity(util::randf() * 0.1f - 0.05f);
-        asteroids[circular_index_asteroids].el.set_velocity({ util::randf() * 2.0f - 1.0f, util::randf() * 2.0f - 1.0f });
+    EntityPool::Policy get_spawn_policy() const { return asteroid_pool.get_policy(); }
 
-        next_index_asteroids();
+    /**
+     * @brief Choose what spawning does when a pool is full, for both asteroids and mooncoins.
+     */
+    void set_spawn_policy(EntityPool::Policy policy) { asteroid_pool.set_policy(policy); mooncoin_pool.set_policy(policy); }
+
+    /**
+     * @brief Spawn an asteroid at a random point of a circle.
+     * @return The handle of the asteroid, stale if the pool is full and refuses to spawn.
+     */
+    EntityHandle spawn_asteroid_nearby(f32_2 position, f32 range) {
+        usize index;
+        const EntityHandle handle = asteroid_pool.allocate(index);
+
+        // Drawn even when refused, so the policy doesn't shift the rest of the world stream.
+        const f32_2 spawn_position = random_point_around(position, range);
+        if (index != EntityPool::NO_INDEX)
+            spawn_asteroid(index, spawn_position);
+
+        return handle;
     }
 
-    void spawn_mooncoin_nearby(f32_2 position, f32 range) {
-        const f32 angle = util::randf() * 2.0f * M_PI;
+    EntityHandle spawn_asteroid_at(f32_2 position) {
+        usize index;
+        const EntityHandle handle = asteroid_pool.allocate(index);
 
-        mooncoins[circular_index_mooncoins].set_position({ position.x + range * ltcosf_q(angle), position.y + range * ltsinf_q(angle) });
-        mooncoins[circular_index_mooncoins].set_angular_velocity(util::randf() * 0.6f - 0.3f);
-        mooncoins[circular_index_mooncoins].set_velocity({ util::randf() * 8.0f - 4.0f, util::randf() * 8.0f - 4.0f });
+        if (index != EntityPool::NO_INDEX)
+            spawn_asteroid(index, position);
 
-        next_index_mooncoins();
+        return handle;
     }
 
-    void spawn_mooncoin_at(f32_2 position) {
-        mooncoins[circular_index_mooncoins].set_position(position);
-        mooncoins[circular_index_mooncoins].set_angular_velocity(util::randf() * 0.6f - 0.3f);
-        mooncoins[circular_index_mooncoins].set_velocity({ util::randf() * 8.0f - 4.0f, util::randf() * 8.0f - 4.0f });
+    /**
+     * @brief Spawn a mooncoin at a random point of a circle.
+     * @return The handle of the mooncoin, stale if the pool is full and refuses to spawn.
+     */
+    EntityHandle spawn_mooncoin_nearby(f32_2 position, f32 range) {
+        usize index;
+        const EntityHandle handle = mooncoin_pool.allocate(index);
+
+        const f32_2 spawn_position = random_point_around(position, range);
+        if (index != EntityPool::NO_INDEX)
+            spawn_mooncoin(index, spawn_position);
 
-        next_index_mooncoins();
+        return handle;
     }
 
-    void randomize_asteroid(usize index) {
-        asteroids[index].el.set_position(
-            { 
-                util::randf() * RANDOMIZER_RANGE - RANDOMIZER_RANGE / 2, 
-                util::randf() * RANDOMIZER_RANGE - RANDOMIZER_RANGE / 2 
-            }
-        );
-        asteroids[index].el.set_angular_velocity(util::randf() * 0.1f - 0.05f);
-        asteroids[index].el.set_velocity({ util::randf() * 2.0f - 1.0f, util::randf() * 2.0f - 1.0f });
-    
-        bool no_collisions = false;
+    EntityHandle spawn_mooncoin_at(f32_2 position) {
+        usize index;
+        const EntityHandle handle = mooncoin_pool.allocate(index);
 
-        for (usize attempts = 0; !no_collisions and attempts < 100; ++attempts) {
-            no_collisions = true;
-            for (usize i = 0; i < get_asteroid_count() - 1; ++i) {
-                if (asteroids[index].el.is_collision(asteroids[i].el)) {
+        if (index != EntityPool::NO_INDEX)
+            spawn_mooncoin(index, position);
 
-                    asteroids[index].el.set_position(
-                        { 
-                            util::randf() * RANDOMIZER_RANGE - RANDOMIZER_RANGE / 2 + (RANDOMIZER_RANGE / 5) * static_cast<f32>(i), 
-                            util::randf() * RANDOMIZER_RANGE - RANDOMIZER_RANGE / 2 + (RANDOMIZER_RANGE / 5) * static_cast<f32>(i)
-                        }
-                    );
-                    asteroids[index].el.set_angular_velocity(util::randf() * 0.1f - 0.05f);
-                    asteroids[index].el.set_velocity({ util::randf() * 2.0f - 1.0f, util::randf() * 2.0f - 1.0f });
+        return handle;
+    }
 
-                    no_collisions = false;
-                    break;
-                }
-            }
+    /**
+     * @brief Destroy an asteroid, moving the last live asteroid into its index.
+     * @return False if the handle was already stale.
+     */
+    bool destroy_asteroid(EntityHandle handle) {
+        const usize index = asteroid_pool.release(handle);
+        if (index == EntityPool::NO_INDEX)
+            return false;
+
+        const usize last = asteroid_pool.size();
+        if (index != last) {
+            asteroids.swap(index, last);
+            std::swap(asteroid_chunks[index], asteroid_chunks[last]);
+            std::swap(asteroid_chunk_ids[index], asteroid_chunk_ids[last]);
+            std::swap(asteroid_touched[index], asteroid_touched[last]);
         }
+
+        return true;
+    }
+
+    /**
+     * @brief Destroy a mooncoin, moving the last live mooncoin into its index.
+     * @return False if the handle was already stale.
+     */
+    bool destroy_mooncoin(EntityHandle handle) {
+        const usize index = mooncoin_pool.release(handle);
+        if (index == EntityPool::NO_INDEX)
+            return false;
+
+        if (index != mooncoin_pool.size())
+            std::swap(mooncoins[index], mooncoins[mooncoin_pool.size()]);
+
+        return true;
     }
 
     void randomize_mooncoin(usize index) {
         mooncoins[index].set_position(
             { 
-                util::randf() * RANDOMIZER_RANGE - RANDOMIZER_RANGE / 2, 
-                util::randf() * RANDOMIZER_RANGE - RANDOMIZER_RANGE / 2 
+                rng.next_f32() * RANDOMIZER_RANGE - RANDOMIZER_RANGE / 2, 
+                rng.next_f32() * RANDOMIZER_RANGE - RANDOMIZER_RANGE / 2 
             }
         );
-        mooncoins[index].set_angular_velocity(util::randf() * 0.6f - 0.3f);
-        mooncoins[index].set_velocity({ util::randf() * 8.0f - 4.0f, util::randf() * 8.0f - 4.0f });
+        mooncoins[index].set_angular_velocity(rng.next_f32() * 0.6f - 0.3f);
+        mooncoins[index].set_velocity({ rng.next_f32() * 8.0f - 4.0f, rng.next_f32() * 8.0f - 4.0f });
     }
 
+    /**
+     * @brief Advance the world by one simulation tick.
+     *
+     * The entities keep their pose from before the tick as the previous state, so that rendering can interpolate
+     * between the last two ticks.
+     *
+     * @param dt_scale The length of the tick, where 1 is 1 / TICK_RATE seconds. The game always steps by 1.
+     */
     void step(f32 dt_scale) {
-        for (usize i = 0; i < get_asteroid_count(); ++i) {
-            const f32_2 astpos = asteroids[i].el.get_position();
-            asteroids[i].out_of_view = (
-                astpos.x < -CULLING_MARGIN + position.x or astpos.x > culling_viewport.x + CULLING_MARGIN + position.x or
-                astpos.y < -CULLING_MARGIN + position.y or astpos.y > culling_viewport.y + CULLING_MARGIN + position.y
-            );
+        PROFILE_ZONE("World::step");
+
+        update_chunks();
+
+        WorkerPool& pool = *workers;
+        const usize count = get_asteroid_count();
+        const f32_2 cull_min = { position.x - CULLING_MARGIN, position.y - CULLING_MARGIN };
+        const f32_2 cull_max = { culling_viewport.x + CULLING_MARGIN + position.x, culling_viewport.y + CULLING_MARGIN + position.y };
+        const f32_2 mid_min = { position.x - MID_MARGIN, position.y - MID_MARGIN };
+        const f32_2 mid_max = { culling_viewport.x + MID_MARGIN + position.x, culling_viewport.y + MID_MARGIN + position.y };
+
+        rover.store_previous_pose();
+        for (usize i = 0; i < get_mooncoin_count(); ++i)
+            mooncoins[i].store_previous_pose();
+
+        // The narrowphase tasks all read the rover outline, so it is built before them.
+        rover.prepare_outline();
+        rover_candidates.resize(count);
+        rover_contacts.resize(count);
+        outline_needed.assign(count, 0);
+
+        // Sort into tiers, and find which asteroids are close enough to the rover to need the narrowphase.
+        {
+            PROFILE_ZONE("World::step tiers");
+            pool.parallel_for(count, ASTEROID_GRAIN, [&](usize begin, usize end) {
+                asteroids.store_previous_poses(begin, end);
+                asteroids.update_tiers(cull_min, cull_max, mid_min, mid_max, begin, end);
+                for (usize i = begin; i < end; ++i)
+                    rover_candidates[i] = !asteroids.is_out_of_view(i) and asteroids.is_broad_overlap(i, rover);
+            });
         }
 
-        for (usize i = 0; i < get_asteroid_count() - 1; ++i) {
-            if (asteroids[i].out_of_view)
-                continue;
+        broadphase.clear();
+        broadphase.insert_all(pool, count, asteroids.get_bounding_boxes(), asteroids.get_out_of_view_flags());
+        const std::vector<SpatialGrid::IndexPair>& pairs = broadphase.find_pairs(pool);
 
-            for (usize j = i + 1; j < get_asteroid_count(); ++j) {
-                if (asteroids[j].out_of_view)
-                    continue;
+        pair_candidates.resize(pairs.size());
+        pair_contacts.resize(pairs.size());
+        pair_pushbacks.resize(pairs.size());
 
-                if (asteroids[i].el.is_collision(asteroids[j].el)) {
-                    const f32_2 pos_i = asteroids[i].el.get_position();
-                    const f32_2 pos_j = asteroids[j].el.get_position();
+        {
+            PROFILE_ZONE("World::step broad test");
+            pool.parallel_for(pairs.size(), PAIR_GRAIN, [&](usize begin, usize end) {
+                for (usize p = begin; p < end; ++p)
+                    pair_candidates[p] = asteroids.is_broad_overlap(pairs[p].first, pairs[p].second);
+            });
+        }
 
-                    asteroids[i].el.add_position({ (pos_i.x - pos_j.x) * COLLISION_PUSHBACK * dt_scale, (pos_i.y - pos_j.y) * COLLISION_PUSHBACK * dt_scale });
-                    asteroids[j].el.add_position({ (pos_j.x - pos_i.x) * COLLISION_PUSHBACK * dt_scale, (pos_j.y - pos_i.y) * COLLISION_PUSHBACK * dt_scale });
+        // Only the asteroids that reach the narrowphase need their outline.
+        {
+            PROFILE_ZONE("World::step outlines");
+            for (usize p = 0; p < pairs.size(); ++p)
+                if (pair_candidates[p])
+                    outline_needed[pairs[p].first] = outline_needed[pairs[p].second] = 1;
+            for (usize i = 0; i < count; ++i)
+                outline_needed[i] |= rover_candidates[i];
+
+            pool.parallel_for(count, ASTEROID_GRAIN, [&](usize begin, usize end) {
+                for (usize i = begin; i < end; ++i)
+                    if (outline_needed[i])
+                        asteroids.update_outline(i);
+            });
+        }
+
+        // Gather the contacts, each pair only writes its own slot.
+        {
+            PROFILE_ZONE("World::step narrowphase");
+            pool.parallel_for(pairs.size(), PAIR_GRAIN, [&](usize begin, usize end) {
+                for (usize p = begin; p < end; ++p) {
+                    pair_contacts[p] = pair_candidates[p] and asteroids.is_narrow_collision(pairs[p].first, pairs[p].second);
+
+                    if (pair_contacts[p]) {
+                        const f32_2 pos_i = asteroids.get(pairs[p].first).get_position();
+                        const f32_2 pos_j = asteroids.get(pairs[p].second).get_position();
+                        pair_pushbacks[p] = { (pos_i.x - pos_j.x) * COLLISION_PUSHBACK * dt_scale, (pos_i.y - pos_j.y) * COLLISION_PUSHBACK * dt_scale };
+                    }
                 }
-            }
+            });
 
-            //DrawCircle(pos_r.x, pos_r.y, 5.0f, RED);
+            pool.parallel_for(count, ASTEROID_GRAIN, [&](usize begin, usize end) {
+                for (usize i = begin; i < end; ++i)
+                    rover_contacts[i] = rover_candidates[i] and asteroids.is_narrow_collision(i, rover);
+            });
+        }
 
-            if (rover.is_collision(asteroids[i].el)) {
-                const f32_2 pos_i = asteroids[i].el.get_position();
-                const f32_2 pos_r = rover.get_position();
-                const f32_2 vel_i = asteroids[i].el.get_velocity();
-                const f32_2 vel_r = rover.get_velocity();
+        // Apply the contacts in a fixed order.
+        {
+            PROFILE_ZONE("World::step contacts");
+            for (usize p = 0; p < pairs.size(); ++p) {
+                if (!pair_contacts[p])
+                    continue;
 
-                asteroids[i].el.add_position(
-                    { 
-                        (pos_i.x - pos_r.x) * COLLISION_PUSHBACK, 
-                        (pos_i.y - pos_r.y) * COLLISION_PUSHBACK 
-                    }
-                );
-                rover.add_position(
-                    { 
-                        (pos_r.x - pos_i.x) * COLLISION_PUSHBACK, 
-                        (pos_r.y - pos_i.y) * COLLISION_PUSHBACK
-                    }
-                );
-                rover.add_velocity(
-                    { 
-                        (vel_r.x - vel_i.x) * COLLISION_PUSHBACK_ROVER_V * dt_scale, 
-                        (vel_r.y - vel_i.y) * COLLISION_PUSHBACK_ROVER_V * dt_scale 
-                    }
-                );
+                const f32_2 pushback = pair_pushbacks[p];
+                asteroid_touched[pairs[p].first] = asteroid_touched[pairs[p].second] = 1;
+                asteroids.get(pairs[p].first).add_position(pushback);
+                asteroids.get(pairs[p].second).add_position({ -pushback.x, -pushback.y });
+            }
+
+            for (usize i = 0; i < count; ++i) {
+                if (rover_contacts[i]) {
+                    asteroid_touched[i] = 1;
+                    const f32_2 pos_i = asteroids.get(i).get_position();
+                    const f32_2 pos_r = rover.get_position();
+                    const f32_2 vel_i = asteroids.get(i).get_velocity();
+                    const f32_2 vel_r = rover.get_velocity();
+
+                    asteroids.get(i).add_position(
+                        { 
+                            (pos_i.x - pos_r.x) * COLLISION_PUSHBACK, 
+                            (pos_i.y - pos_r.y) * COLLISION_PUSHBACK 
+                        }
+                    );
+                    rover.add_position(
+                        { 
+                            (pos_r.x - pos_i.x) * COLLISION_PUSHBACK, 
+                            (pos_r.y - pos_i.y) * COLLISION_PUSHBACK
+                        }
+                    );
+                    rover.add_velocity(
+                        { 
+                            (vel_r.x - vel_i.x) * COLLISION_PUSHBACK_ROVER_V * dt_scale, 
+                            (vel_r.y - vel_i.y) * COLLISION_PUSHBACK_ROVER_V * dt_scale 
+                        }
+                    );
 
-                f32 damage = (vel_i.x * vel_i.x + vel_i.y * vel_i.y - vel_r.x * vel_r.x + vel_r.y * vel_r.y);
-                damage *= damage * 0.03f;
-                rover.add_health(-damage);
+                    f32 damage = (vel_i.x * vel_i.x + vel_i.y * vel_i.y - vel_r.x * vel_r.x + vel_r.y * vel_r.y);
+                    damage *= damage * 0.03f;
+                    rover.add_health(-damage);
 
-                if (on_asteroid_collision)
-                    on_asteroid_collision();
+                    if (on_asteroid_collision)
+                        on_asteroid_collision();
+                }
             }
         }
 
-        for (usize i = 0; i < get_asteroid_count(); ++i) {
-            if (asteroids[i].out_of_view)
-                continue;
-            
-            asteroids[i].el.step(dt_scale);
+        {
+            PROFILE_ZONE("World::step integrate");
+            pool.parallel_for(count, ASTEROID_GRAIN, [&](usize begin, usize end) {
+                asteroids.step(dt_scale, begin, end);
+            });
+            asteroids.advance_time(dt_scale);
         }
 
-        for (usize i = 0; i < get_mooncoin_count(); ++i) {
-            if (mooncoins[i].is_collision(rover)) {
-                rover.add_health(Mooncoin::RECOVERY_AMOUNT);
-                if (rover.get_health() > Rover::DEFAULT_MAX_HEALTH)
-                    rover.set_health(Rover::DEFAULT_MAX_HEALTH);
-                randomize_mooncoin(i);
+        {
+            PROFILE_ZONE("World::step mooncoins and rover");
+            for (usize i = 0; i < get_mooncoin_count(); ++i) {
+                if (mooncoins[i].is_collision(rover)) {
+                    rover.add_health(Mooncoin::RECOVERY_AMOUNT);
+                    if (rover.get_health() > Rover::DEFAULT_MAX_HEALTH)
+                        rover.set_health(Rover::DEFAULT_MAX_HEALTH);
+                    randomize_mooncoin(i);
+
+                    ++collected_mooncoins;
 
-                ++collected_mooncoins;
+                    if (on_mooncoin_collect)
+                        on_mooncoin_collect();
+                }
 
-                if (on_mooncoin_collect)
-                    on_mooncoin_collect();
+                mooncoins[i].step(dt_scale);
             }
 
-            mooncoins[i].step(dt_scale);
+            rover.step(dt_scale);
         }
+    }
 
-        rover.step(dt_scale);
+    /**
+     * @brief Find the asteroids and mooncoins to draw, whose bounding box overlaps the camera rectangle.
+     *
+     * The camera rectangle is as large as the culling viewport, grown by RENDER_MARGIN rather than the much wider
+     * CULLING_MARGIN used by the simulation. Asteroids culled by the last step are skipped right away, as the
+     * simulation area always contains the camera rectangle.
+     *
+     * @param view The minimum corner of the camera rectangle, which can be the interpolated camera position.
+     */
+    void update_visible(f32_2 view) {
+        const f32_2 view_box[2] = {
+            { view.x - RENDER_MARGIN, view.y - RENDER_MARGIN },
+            { view.x + culling_viewport.x + RENDER_MARGIN, view.y + culling_viewport.y + RENDER_MARGIN }
+        };
+
+        visible_asteroids.clear();
+        for (usize i = 0; i < get_asteroid_count(); ++i)
+            if (!asteroids.is_out_of_view(i) and Entity::is_overlap(asteroids.get_bounding_box(i), view_box))
+                visible_asteroids.push_back(i);
+
+        visible_mooncoins.clear();
+        for (usize i = 0; i < get_mooncoin_count(); ++i)
+            if (Entity::is_overlap(mooncoins[i].get_bounding_box(), view_box))
+                visible_mooncoins.push_back(i);
     }
 
-    Asteroid& get_asteroid(usize index) { return asteroids[index].el; }
-    usize get_asteroid_count() const { return CIRCULAR_BUFFER_ASTEROIDS; }
+    /**
+     * @brief Get the indexes of the asteroids found by the last update_visible(), in increasing order.
+     */
+    const std::vector<usize>& get_visible_asteroids() const { return visible_asteroids; }
+
+    /**
+     * @brief Get the indexes of the mooncoins found by the last update_visible(), in increasing order.
+     */
+    const std::vector<usize>& get_visible_mooncoins() const { return visible_mooncoins; }
+
+    /* Live entities take the indexes [0, count), which change as others are destroyed, unlike their handles. */
+
+    AsteroidStore::Ref get_asteroid(usize index) { return asteroids.get(index); }
+    usize get_asteroid_count() const { return asteroid_pool.size(); }
+    usize get_asteroid_capacity() const { return asteroid_pool.capacity(); }
+    usize get_loaded_chunk_count() const { return loaded_chunks.size(); }
+    usize get_chunk_diff_count() const { return chunks->get_diff_count(); }
+    EntityHandle get_asteroid_handle(usize index) const { return asteroid_pool.handle_of(index); }
+    usize get_asteroid_index(EntityHandle handle) const { return asteroid_pool.index_of(handle); }
+
     Mooncoin& get_mooncoin(usize index) { return mooncoins[index]; }
-    usize get_mooncoin_count() const { return CIRCULAR_BUFFER_MOONCOINS; }
+    usize get_mooncoin_count() const { return mooncoin_pool.size(); }
+    usize get_mooncoin_capacity() const { return mooncoin_pool.capacity(); }
+    EntityHandle get_mooncoin_handle(usize index) const { return mooncoin_pool.handle_of(index); }
+    usize get_mooncoin_index(EntityHandle handle) const { return mooncoin_pool.index_of(handle); }
 };
 
 #endif
\ No newline at end of file